@@ -0,0 +1,51 @@
+/*
+ * Minimal benchmark harness shared by the benchmark executables.
+ *
+ * Every measurement prints one tab separated line:
+ *
+ *     name    items    iterations    ns_per_iteration    result
+ *
+ * result is a checksum returned by the benchmarked code, both to keep the
+ * compiler from discarding the work and to compare between runs. Call
+ * bench_header() once before the first measurement.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstdio>
+#include <chrono>
+
+typedef std::chrono::steady_clock BenchClock;
+
+static const int BENCH_MIN_MS = 200; /// Minimum time spent per measurement
+
+static inline void bench_header()
+{
+    printf("name\titems\titerations\tns_per_iteration\tresult\n");
+}
+
+/// Runs f once to warm up, then repeatedly for at least BENCH_MIN_MS and
+/// reports the mean. f returns a long checksum.
+template <typename F>
+static void bench(const char *name, int items, F f)
+{
+    long result = f();
+    int iterations = 1;
+    auto start = BenchClock::now();
+    auto elapsed = BenchClock::duration::zero();
+
+    for (;;) {
+        result = f();
+        elapsed = BenchClock::now() - start;
+        if (elapsed > std::chrono::milliseconds(BENCH_MIN_MS))
+            break;
+        iterations++;
+    }
+
+    double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    printf("%s\t%d\t%d\t%.0f\t%ld\n", name, items, iterations, ns / iterations, result);
+    fflush(stdout);
+}
+
+#endif
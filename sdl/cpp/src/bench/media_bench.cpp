@@ -0,0 +1,210 @@
+/*
+ * Benchmarks for MediaLib and UILib hot paths.
+ *
+ * Runs on a headless State, so it needs no display and measures the software
+ * renderer for anything that draws. Output is in the format described in
+ * bench.hpp.
+ *
+ *     mediabench [font path]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "media/media.hpp"
+#include "ui/ui.hpp"
+#include "bench.hpp"
+
+using namespace media;
+
+static const int sizes[] = { 10, 100, 1000 };
+
+static const Gravity gravities[] = {
+    CENTER, TOPLEFT, TOP, TOPRIGHT, RIGHT, BOTTOMRIGHT, BOTTOM, BOTTOMLEFT, LEFT
+};
+
+/// A string of n printable characters.
+static std::string make_string(int n, char first)
+{
+    std::string k(n, ' ');
+    for (int i = 0; i < n; i++)
+        k[i] = first + i % 26;
+    return k;
+}
+
+static long checksum(const Rect &k)
+{
+    return k.x + k.y + k.w + k.h;
+}
+
+/* ===== Geometry ===== */
+
+static void bench_geometry(State &m, Graphics &g)
+{
+    for (int n: sizes) {
+        ui::Frame f(m, g, "bench");
+        f.geo.add(n / 4 > 0 ? n / 4 : 1, 4);
+        ui::Label *mid = nullptr;
+        for (int i = 0; i < n; i++) {
+            ui::Label &l = f.add<ui::Label>("label");
+            if (i == n / 2)
+                mid = &l;
+        }
+
+        Rect dims = { 0, 0, 800, 600 };
+        bench("grid.calculate_all", n, [&]() {
+            // Alternate widths so no call can be skipped as a no-op.
+            dims.w = dims.w == 800 ? 640 : 800;
+            return checksum(f.geo.calculate_all(dims));
+        });
+
+        Point pos = { 0, 0 };
+        bench("grid.translate_all", n, [&]() {
+            pos.x = pos.x == 0 ? 10 : 0;
+            return checksum(f.geo.translate_all(pos));
+        });
+
+        // One widget in the middle grows and shrinks, as a label would.
+        int h = mid->measured.h;
+        bench("grid.relayout", n, [&]() {
+            size_t first, last;
+            mid->set_measured((Size) { mid->measured.w,
+                                       mid->measured.h == h ? h + 8 : h });
+            f.geo.relayout(first, last);
+            return checksum(f.geo.container_dim);
+        });
+
+        ui::TopLevel t(m, g, "bench");
+        for (int i = 0; i < n; i++) {
+            t.geo.add(gravities[i % 9], i % 7, i % 5);
+            t.add<ui::Label>("label");
+        }
+
+        bench("relative.calculate_all", n, [&]() {
+            dims.w = dims.w == 800 ? 640 : 800;
+            return checksum(t.geo.calculate_all(dims));
+        });
+    }
+}
+
+static void bench_align()
+{
+    for (int n: sizes) {
+        std::vector<Rect> in(n);
+        for (int i = 0; i < n; i++)
+            in[i] = (Rect) { 0, 0, 10 + i % 50, 10 + i % 30 };
+
+        Rect out = { 5, 5, 300, 200 };
+        bench("util.rect_align", n, [&]() {
+            long sum = 0;
+            for (Gravity k: gravities) {
+                for (auto &i: in)
+                    sum += checksum(util::rect_align(out, i, k, 3, 3));
+            }
+            return sum;
+        });
+    }
+}
+
+/* ===== Text ===== */
+
+static void bench_text(State &m, Graphics &g, const char *font_path)
+{
+    Text txt(m, font_path);
+    Object o;
+
+    for (int n: sizes) {
+        std::string a = make_string(n, 'a'), b = make_string(n, 'A');
+        bool flip = false;
+
+        bench("text.text", n, [&]() {
+            flip = !flip;
+            txt.text(g, o, flip ? a : b);
+            return (long) o.dest_rect.w;
+        });
+
+        bench("graphics.text", n, [&]() {
+            flip = !flip;
+            g.text(o, flip ? a : b);
+            return (long) o.dest_rect.w;
+        });
+    }
+}
+
+/* ===== Widgets ===== */
+
+static void bench_widgets(State &m, Graphics &g)
+{
+    for (int n: sizes) {
+        ui::Label l(m, g, "label");
+        std::string a = make_string(n, 'a'), b = make_string(n, 'A');
+        bool flip = false;
+
+        bench("label.set_label", n, [&]() {
+            flip = !flip;
+            l.set_label(flip ? a : b);
+            return (long) l.dims.w;
+        });
+    }
+
+    for (int n: sizes) {
+        ui::Frame f(m, g, "bench");
+        f.geo.add(n / 4 > 0 ? n / 4 : 1, 4);
+        for (int i = 0; i < n; i++)
+            f.add<ui::Button>("button");
+        f.resize((Rect) { 0, 0, 800, 600 });
+
+        // Motion across the frame, so buttons change state as in real use.
+        int x = 0;
+        bench("container.event", n, [&]() {
+            x = (x + 37) % 800;
+            m.e.type = SDL_MOUSEMOTION;
+            m.e.motion.x = x;
+            m.e.motion.y = x % 600;
+            return (long) f.event();
+        });
+    }
+}
+
+/// Builds and tears down a dialog, from the heap and from an arena.
+static void bench_build(State &m, Graphics &g)
+{
+    for (int n: sizes) {
+        for (int opts: { 0, (int) ui::OPT_WIDGET_ARENA }) {
+            ui::TopLevel t(m, g, "bench", opts);
+
+            bench(opts ? "toplevel.build_arena" : "toplevel.build_heap", n, [&]() {
+                auto &f = t.add<ui::Frame>("frame");
+                for (int i = 0; i < n; i++)
+                    f.add<ui::Label>("label");
+                t.refresh();
+                t.clear();
+                return (long) n;
+            });
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *font_path = argc > 1 ? argv[1] : "assets/font.otb";
+
+    try {
+        State m(800, 600, 0, "MediaBench", font_path, STATE_HEADLESS);
+        Graphics g(m);
+
+        bench_header();
+        bench_geometry(m, g);
+        bench_align();
+        bench_text(m, g, font_path);
+        bench_widgets(m, g);
+        bench_build(m, g);
+    } catch (int err_code) {
+        fprintf(stderr, "[BENCH] Exiting with error code %d\n", err_code);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Benchmarks for SpatialHash.
+ *
+ * Random rectangles are spread over a world that grows with the item count,
+ * so density stays constant and the numbers show how cost scales with N.
+ * Output is in the format described in bench.hpp; result is the pair or hit
+ * count.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "media/media.hpp"
+#include "bench.hpp"
+
+using namespace media;
+
+static std::vector<Rect> make_rects(int n, unsigned seed)
+{
+    std::vector<Rect> k(n);
+    int world = (int) (std::sqrt((double) n) * 40);
+
+    srand(seed);
+    for (auto &i: k) {
+        i.w = 4 + rand() % 29;
+        i.h = 4 + rand() % 29;
+        i.x = rand() % world;
+        i.y = rand() % world;
+    }
+
+    return k;
+}
+
+int main()
+{
+    const int sizes[] = { 1000, 10000, 100000 };
+
+    bench_header();
+
+    for (int n: sizes) {
+        std::vector<Rect> rects = make_rects(n, 1);
+        std::vector<SpatialHash::Pair> pairs;
+        std::vector<int> hits;
+        SpatialHash hash(32, 16);
+
+        bench("spatial.build", n, [&]() {
+            hash.build(rects);
+            return (long) hash.size();
+        });
+
+        bench("spatial.pairs", n, [&]() {
+            pairs.clear();
+            hash.pairs(pairs);
+            return (long) pairs.size();
+        });
+
+        bench("spatial.build_pairs", n, [&]() {
+            hash.build(rects);
+            pairs.clear();
+            hash.pairs(pairs);
+            return (long) pairs.size();
+        });
+
+        // One query per item, as when testing bullets against enemies.
+        bench("spatial.query_all", n, [&]() {
+            hits.clear();
+            for (auto &i: rects)
+                hash.query(i, hits);
+            return (long) hits.size();
+        });
+
+        // The naive pairing is quadratic; keep it to sizes that finish.
+        if (n <= 10000) {
+            bench("naive.pairs", n, [&]() {
+                long count = 0;
+                for (int i = 0; i < n; i++) {
+                    for (int j = i + 1; j < n; j++)
+                        count += util::rects_overlap(rects[i], rects[j]);
+                }
+                return count;
+            });
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,691 @@
+/*
+ * A small archetype based entity component system.
+ *
+ * Entities with the same set of components share an archetype. Each archetype
+ * stores its entities in fixed size chunks, and inside a chunk every component
+ * has its own contiguous array. A query walks the chunks of every matching
+ * archetype, so iterating over thousands of entities is a walk over a few
+ * flat arrays instead of over scattered objects.
+ *
+ * Components are plain data: they are moved between chunks with memcpy and
+ * are never constructed or destroyed.
+ *
+ * Adding or removing components, spawning and destroying are structural
+ * changes. They move rows around and so are not allowed while a query is
+ * running; record them in the world's CommandBuffer instead, which the
+ * Scheduler plays back between systems.
+ */
+
+#ifndef ECS_H
+#define ECS_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <functional>
+#include <type_traits>
+
+namespace ecs {
+
+static const int MAX_COMPONENTS = 64;
+static const int CHUNK_BYTES    = 16384;
+
+/// Set of component ids, one bit each.
+typedef uint64_t Signature;
+
+/// Entity handle. The generation tells a reused index from a dead handle.
+struct Entity {
+    uint32_t index;
+    uint32_t generation;
+
+    inline bool operator==(const Entity &k) const
+    {
+        return index == k.index && generation == k.generation;
+    }
+
+    inline bool operator!=(const Entity &k) const
+    {
+        return !(*this == k);
+    }
+};
+
+static const Entity NO_ENTITY = { UINT32_MAX, 0 };
+
+class World;
+class Archetype;
+
+/*
+ * =============================================================================
+ * Component ids
+ * =============================================================================
+ */
+
+struct ComponentInfo {
+    size_t size;
+    size_t align;
+};
+
+inline std::vector<ComponentInfo> &component_info()
+{
+    static std::vector<ComponentInfo> k;
+    return k;
+}
+
+inline int register_component(size_t size, size_t align)
+{
+    std::vector<ComponentInfo> &k = component_info();
+
+    if (k.size() == MAX_COMPONENTS) {
+        fprintf(stderr, "ecs: more than %d component types\n", MAX_COMPONENTS);
+        abort();
+    }
+
+    k.push_back((ComponentInfo) { size, align });
+    return k.size() - 1;
+}
+
+/// Ids are handed out on first use.
+template <typename T>
+inline int component_id()
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "components are moved with memcpy");
+    static const int id = register_component(sizeof(T), alignof(T));
+    return id;
+}
+
+template <typename ...Cs>
+struct SignatureOf;
+
+template <>
+struct SignatureOf<> {
+    static inline Signature get()
+    {
+        return 0;
+    }
+};
+
+template <typename C, typename ...Cs>
+struct SignatureOf<C, Cs...> {
+    static inline Signature get()
+    {
+        return ((Signature) 1 << component_id<C>()) | SignatureOf<Cs...>::get();
+    }
+};
+
+/*
+ * =============================================================================
+ * Archetype
+ * =============================================================================
+ */
+
+/// Rows of one archetype. Every chunk but the last is full.
+struct Chunk {
+    std::unique_ptr<unsigned char[]> data;
+    int count;
+};
+
+class Archetype {
+    protected:
+        std::unique_ptr<unsigned char[]> spare; /// Last freed chunk, for reuse
+        size_t chunk_bytes;
+
+    public:
+        Signature sig;
+        int capacity;   /// Rows per chunk
+        int count = 0;  /// Rows in total
+        std::vector<int> ids;         /// Component id of each column
+        std::vector<size_t> sizes;
+        std::vector<size_t> offsets;  /// Column offsets into a chunk
+        int column_of[MAX_COMPONENTS];
+        std::vector<Chunk> chunks;
+
+        inline Archetype(Signature sig);
+
+        inline Entity *entities(Chunk &c)
+        {
+            return (Entity *) c.data.get();
+        }
+
+        inline unsigned char *at(uint32_t chunk, uint32_t row, int col)
+        {
+            return chunks[chunk].data.get() + offsets[col] + sizes[col] * row;
+        }
+
+        template <typename T>
+        inline T *column(Chunk &c)
+        {
+            return (T *) (c.data.get() + offsets[column_of[component_id<T>()]]);
+        }
+
+        inline bool has(int id)
+        {
+            return column_of[id] >= 0;
+        }
+
+        /// Appends a row for e. Its components are left uninitialised.
+        inline void push(Entity e, uint32_t &chunk, uint32_t &row);
+
+        /// Removes a row by moving the last row into it.
+        /// @return the entity that was moved, or NO_ENTITY.
+        inline Entity erase(uint32_t chunk, uint32_t row);
+};
+
+/**
+ * The entity array comes first, then each column, aligned. Alignments beyond
+ * that of new[] aren't honoured.
+ */
+inline Archetype::Archetype(Signature sig): sig(sig)
+{
+    size_t row_bytes = sizeof(Entity);
+    size_t slack = 0;
+
+    for (int i = 0; i < MAX_COMPONENTS; i++) {
+        column_of[i] = -1;
+        if (!(sig & ((Signature) 1 << i)))
+            continue;
+
+        ComponentInfo k = component_info()[i];
+        column_of[i] = ids.size();
+        ids.push_back(i);
+        sizes.push_back(k.size);
+        row_bytes += k.size;
+        slack += k.align;
+    }
+
+    capacity = (CHUNK_BYTES - slack) / row_bytes;
+    if (capacity < 1)
+        capacity = 1;
+
+    size_t off = capacity * sizeof(Entity);
+    for (size_t i = 0; i < ids.size(); i++) {
+        size_t align = component_info()[ids[i]].align;
+        off = (off + align - 1) / align * align;
+        offsets.push_back(off);
+        off += sizes[i] * capacity;
+    }
+
+    chunk_bytes = off;
+}
+
+inline void Archetype::push(Entity e, uint32_t &chunk, uint32_t &row)
+{
+    if (chunks.empty() || chunks.back().count == capacity) {
+        Chunk k;
+        k.data = spare ? std::move(spare) :
+                 std::unique_ptr<unsigned char[]>(new unsigned char[chunk_bytes]);
+        k.count = 0;
+        chunks.push_back(std::move(k));
+    }
+
+    Chunk &c = chunks.back();
+    chunk = chunks.size() - 1;
+    row = c.count++;
+    entities(c)[row] = e;
+    count++;
+}
+
+inline Entity Archetype::erase(uint32_t chunk, uint32_t row)
+{
+    Chunk &last = chunks.back();
+    uint32_t last_chunk = chunks.size() - 1;
+    uint32_t last_row = last.count - 1;
+    Entity moved = NO_ENTITY;
+
+    if (chunk != last_chunk || row != last_row) {
+        moved = entities(last)[last_row];
+        entities(chunks[chunk])[row] = moved;
+        for (size_t i = 0; i < ids.size(); i++)
+            memcpy(at(chunk, row, i), at(last_chunk, last_row, i), sizes[i]);
+    }
+
+    count--;
+    if (--last.count == 0) {
+        spare = std::move(last.data);
+        chunks.pop_back();
+    }
+
+    return moved;
+}
+
+/*
+ * =============================================================================
+ * Command buffer
+ * =============================================================================
+ */
+
+/// Structural changes recorded for later, e.g. from inside a query.
+class CommandBuffer {
+    protected:
+        std::vector<std::function<void(World &)>> commands;
+
+    public:
+        template <typename ...Cs>
+        inline void spawn(const Cs &...cs);
+        inline void destroy(Entity e);
+
+        template <typename T>
+        inline void add(Entity e, const T &k);
+
+        template <typename T>
+        inline void remove(Entity e);
+
+        /// Applies and clears the recorded commands, in order.
+        inline void apply(World &w);
+
+        inline bool empty()
+        {
+            return commands.empty();
+        }
+};
+
+/*
+ * =============================================================================
+ * World
+ * =============================================================================
+ */
+
+class World {
+    protected:
+        struct Record {
+            Archetype *arch;
+            uint32_t chunk;
+            uint32_t row;
+            uint32_t generation;
+            bool alive;
+        };
+
+        std::vector<Record> records;
+        std::vector<uint32_t> free_list;
+        std::vector<std::unique_ptr<Archetype>> archetypes;
+        std::map<Signature, Archetype *> by_sig;
+        CommandBuffer cmds;
+        int entity_count = 0;
+        int iterating = 0; /// Queries currently running
+
+        inline void check_structural(const char *op);
+        inline void move(Entity e, Archetype *dest);
+
+        template <typename T>
+        inline void write(Archetype *a, uint32_t chunk, uint32_t row, const T &k)
+        {
+            memcpy(a->at(chunk, row, a->column_of[component_id<T>()]), &k, sizeof(T));
+        }
+
+        template <typename ...Cs> friend class Query;
+
+    public:
+        World() {}
+        World(const World &) = delete;
+
+        /// Archetype with the given components, created if needed.
+        inline Archetype *archetype(Signature sig);
+
+        template <typename ...Cs>
+        inline Entity spawn(const Cs &...cs);
+        inline void destroy(Entity e);
+        inline bool alive(Entity e);
+
+        /// @return the component, or nullptr if e is dead or lacks it.
+        template <typename T>
+        inline T *get(Entity e);
+
+        template <typename T>
+        inline bool has(Entity e);
+
+        /// Adds the component, or overwrites it if present.
+        template <typename T>
+        inline void add(Entity e, const T &k);
+
+        template <typename T>
+        inline void remove(Entity e);
+
+        /// Calls f(Entity, Cs &...) for every entity having all of Cs.
+        template <typename ...Cs, typename F>
+        inline void each(F f);
+
+        inline CommandBuffer &commands()
+        {
+            return cmds;
+        }
+
+        inline int size()
+        {
+            return entity_count;
+        }
+
+        inline const std::vector<std::unique_ptr<Archetype>> &get_archetypes()
+        {
+            return archetypes;
+        }
+};
+
+inline void World::check_structural(const char *op)
+{
+    if (iterating > 0) {
+        fprintf(stderr, "ecs: %s inside a query, use the command buffer\n", op);
+        abort();
+    }
+}
+
+inline Archetype *World::archetype(Signature sig)
+{
+    auto i = by_sig.find(sig);
+    if (i != by_sig.end())
+        return i->second;
+
+    Archetype *k = new Archetype(sig);
+    archetypes.push_back(std::unique_ptr<Archetype>(k));
+    by_sig[sig] = k;
+    return k;
+}
+
+template <typename ...Cs>
+inline Entity World::spawn(const Cs &...cs)
+{
+    check_structural("spawn");
+
+    Entity e;
+    if (free_list.empty()) {
+        e.index = records.size();
+        e.generation = 0;
+        records.push_back((Record) { nullptr, 0, 0, 0, false });
+    } else {
+        e.index = free_list.back();
+        e.generation = records[e.index].generation;
+        free_list.pop_back();
+    }
+
+    Record &r = records[e.index];
+    r.arch = archetype(SignatureOf<Cs...>::get());
+    r.arch->push(e, r.chunk, r.row);
+    r.alive = true;
+    entity_count++;
+
+    int expand[] = { 0, (write(r.arch, r.chunk, r.row, cs), 0)... };
+    (void) expand;
+    return e;
+}
+
+inline void World::destroy(Entity e)
+{
+    check_structural("destroy");
+    if (!alive(e))
+        return;
+
+    Record &r = records[e.index];
+    Entity moved = r.arch->erase(r.chunk, r.row);
+    if (moved != NO_ENTITY) {
+        records[moved.index].chunk = r.chunk;
+        records[moved.index].row = r.row;
+    }
+
+    r.alive = false;
+    r.arch = nullptr;
+    r.generation++;
+    free_list.push_back(e.index);
+    entity_count--;
+}
+
+inline bool World::alive(Entity e)
+{
+    return e.index < records.size() && records[e.index].alive &&
+           records[e.index].generation == e.generation;
+}
+
+/// Moves e's row to dest, keeping the components both archetypes have.
+inline void World::move(Entity e, Archetype *dest)
+{
+    Record &r = records[e.index];
+    Archetype *src = r.arch;
+    uint32_t chunk, row;
+
+    dest->push(e, chunk, row);
+    for (size_t i = 0; i < dest->ids.size(); i++) {
+        int col = src->column_of[dest->ids[i]];
+        if (col >= 0)
+            memcpy(dest->at(chunk, row, i), src->at(r.chunk, r.row, col), dest->sizes[i]);
+    }
+
+    Entity moved = src->erase(r.chunk, r.row);
+    if (moved != NO_ENTITY) {
+        records[moved.index].chunk = r.chunk;
+        records[moved.index].row = r.row;
+    }
+
+    r.arch = dest;
+    r.chunk = chunk;
+    r.row = row;
+}
+
+template <typename T>
+inline T *World::get(Entity e)
+{
+    if (!alive(e))
+        return nullptr;
+
+    Record &r = records[e.index];
+    int col = r.arch->column_of[component_id<T>()];
+    return col < 0 ? nullptr : (T *) r.arch->at(r.chunk, r.row, col);
+}
+
+template <typename T>
+inline bool World::has(Entity e)
+{
+    return alive(e) && records[e.index].arch->has(component_id<T>());
+}
+
+template <typename T>
+inline void World::add(Entity e, const T &k)
+{
+    if (!alive(e))
+        return;
+
+    Record &r = records[e.index];
+    if (!r.arch->has(component_id<T>())) {
+        check_structural("add");
+        move(e, archetype(r.arch->sig | SignatureOf<T>::get()));
+    }
+
+    write(r.arch, r.chunk, r.row, k);
+}
+
+template <typename T>
+inline void World::remove(Entity e)
+{
+    if (!has<T>(e))
+        return;
+
+    check_structural("remove");
+    Record &r = records[e.index];
+    move(e, archetype(r.arch->sig & ~SignatureOf<T>::get()));
+}
+
+/*
+ * =============================================================================
+ * Query
+ * =============================================================================
+ */
+
+/**
+ * Iterates over every entity having all of Cs. The matching archetypes are
+ * cached, and only archetypes created since the last run are checked again,
+ * so a long lived query costs nothing to keep up to date.
+ */
+template <typename ...Cs>
+class Query {
+    protected:
+        World &w;
+        Signature sig;
+        std::vector<Archetype *> matched;
+        size_t seen = 0; /// Archetypes already checked
+
+        inline void update()
+        {
+            auto &k = w.archetypes;
+            for (; seen < k.size(); seen++) {
+                if ((k[seen]->sig & sig) == sig)
+                    matched.push_back(k[seen].get());
+            }
+        }
+
+        template <typename F, typename ...Ps>
+        static inline void rows(F &f, int n, Entity *e, Ps *...cols)
+        {
+            for (int i = 0; i < n; i++)
+                f(e[i], cols[i]...);
+        }
+
+    public:
+        Query(World &w): w(w), sig(SignatureOf<Cs...>::get()) {}
+
+        /// Calls f(Entity, Cs &...) for every entity.
+        template <typename F>
+        inline void each(F f);
+
+        /**
+         * Calls f(int n, Entity *, Cs *...) once per chunk, with the chunk's
+         * arrays. Suited to loops the compiler should vectorise.
+         */
+        template <typename F>
+        inline void each_chunk(F f);
+
+        inline int count();
+};
+
+template <typename ...Cs>
+template <typename F>
+inline void Query<Cs...>::each(F f)
+{
+    update();
+    w.iterating++;
+
+    for (Archetype *a: matched) {
+        for (Chunk &c: a->chunks)
+            rows(f, c.count, a->entities(c), a->template column<Cs>(c)...);
+    }
+
+    w.iterating--;
+}
+
+template <typename ...Cs>
+template <typename F>
+inline void Query<Cs...>::each_chunk(F f)
+{
+    update();
+    w.iterating++;
+
+    for (Archetype *a: matched) {
+        for (Chunk &c: a->chunks)
+            f(c.count, a->entities(c), a->template column<Cs>(c)...);
+    }
+
+    w.iterating--;
+}
+
+template <typename ...Cs>
+inline int Query<Cs...>::count()
+{
+    int n = 0;
+
+    update();
+    for (Archetype *a: matched)
+        n += a->count;
+
+    return n;
+}
+
+template <typename ...Cs, typename F>
+inline void World::each(F f)
+{
+    Query<Cs...>(*this).each(f);
+}
+
+/*
+ * CommandBuffer methods need a complete World.
+ */
+
+template <typename ...Cs>
+inline void CommandBuffer::spawn(const Cs &...cs)
+{
+    commands.push_back(std::bind(&World::spawn<Cs...>, std::placeholders::_1, cs...));
+}
+
+inline void CommandBuffer::destroy(Entity e)
+{
+    commands.push_back([e](World &w) { w.destroy(e); });
+}
+
+template <typename T>
+inline void CommandBuffer::add(Entity e, const T &k)
+{
+    commands.push_back([e, k](World &w) { w.add(e, k); });
+}
+
+template <typename T>
+inline void CommandBuffer::remove(Entity e)
+{
+    commands.push_back([e](World &w) { w.template remove<T>(e); });
+}
+
+inline void CommandBuffer::apply(World &w)
+{
+    // Commands may record further commands; those run on the next apply().
+    std::vector<std::function<void(World &)>> k;
+    k.swap(commands);
+
+    for (auto &i: k)
+        i(w);
+}
+
+/*
+ * =============================================================================
+ * Scheduler
+ * =============================================================================
+ */
+
+typedef std::function<void(World &, float)> System;
+
+/// Runs systems in the order they were added, applying the world's command
+/// buffer after each so that the next system sees its changes.
+class Scheduler {
+    protected:
+        struct Entry {
+            std::string name;
+            System run;
+            bool enabled;
+        };
+
+        std::vector<Entry> systems;
+
+    public:
+        inline int add(const std::string &name, System f)
+        {
+            systems.push_back((Entry) { name, f, true });
+            return systems.size() - 1;
+        }
+
+        inline void enable(int id, bool k)
+        {
+            systems[id].enabled = k;
+        }
+
+        inline void run(World &w, float dt)
+        {
+            for (auto &i: systems) {
+                if (!i.enabled)
+                    continue;
+                i.run(w, dt);
+                w.commands().apply(w);
+            }
+        }
+};
+
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <SDL2/SDL.h>
@@ -20,18 +21,51 @@ int media_main() {
     SceneState s = SCENE_TITLE;
     bool quitmode = false;
 
-    Object debug;
+    // MEDIA_HEADLESS=<frames> runs without a window for that many frames, as
+    // fast as possible. 0 runs until quit.
+    const char *headless = getenv("MEDIA_HEADLESS");
+    int frame_limit = headless ? atoi(headless) : 0;
+    int frames = 0;
 
-    State m;
+    // MEDIA_RECORD=<file> records the input of the run, MEDIA_REPLAY=<file>
+    // plays it back as fast as possible.
+    const char *record = getenv("MEDIA_RECORD");
+    const char *replay = getenv("MEDIA_REPLAY");
+    bool flat_out = headless || replay;
+
+    State m(800, 600, flat_out ? 0 : 60, "MediaEngine", "assets/font.otb",
+            headless ? STATE_HEADLESS : 0);
     Graphics g(m);
+    Loop loop(m, 60, flat_out ? Loop::PACING_FIXED : Loop::PACING_VSYNC);
+
+    // MEDIA_TRACE=<file> enables the profiler in builds with MEDIA_PROFILE.
+    // The trace is written there on exit, or when F12 is pressed.
+    const char *trace = getenv("MEDIA_TRACE");
+    Profiler::enable(trace != nullptr);
+
+    InputReplay input;
+    if (replay && input.play(replay))
+        m.seed = input.seed();
+    else if (record)
+        input.record(record, m.seed);
+
+    Loader loader(m);
+    g.batch(true);
+    g.defer(true);
 
     TitleScene title_scene(m, g, s);
-    GameScene  game_scene(m, g, s);
+    GameScene  game_scene(m, g, s, loader);
     QuitScene  quit_scene(m, g, s);
 
-    Text txt(m, Text::FontDataType::FONT_DATA_STANDARD, "assets/font.otb");
-    Object text;
-    txt.text(text, "HelloHi");
+    DebugOverlay overlay(m, g, *m.text);
+    int fps_slot     = overlay.add("fps");
+    int batches_slot = overlay.add("batches");
+    int p99_slot     = overlay.add("p99 ms");
+    int draws_slot   = overlay.add("draw calls");
+    int switch_slot  = overlay.add("tex switches");
+    int target_slot  = overlay.add("targets");
+    int tex_slot     = overlay.add("textures");
+    int vram_slot    = overlay.add("vram KiB");
 
     game_scene.init();
     title_scene.init();
@@ -40,79 +74,141 @@ int media_main() {
     scene_list[SCENE_GAME] = &game_scene;
     scene_list[SCENE_TITLE] = &title_scene;
 
+    // Only the scene being shown has its subscriptions enabled. None is
+    // while the quit dialog is up.
+    Scene *active = nullptr;
+    auto switch_scene = [&]() {
+        Scene *k = quitmode ? nullptr : scene_list[s];
+        if (k == active)
+            return;
+        if (active)
+            active->deactivate();
+        if (k)
+            k->activate();
+        active = k;
+    };
+    switch_scene();
+
     SDL_StartTextInput();
     Rect c = {0, 0, 200, 200};
     SDL_SetTextInputRect(&c);
     std::string textbuf;
 
-    while (m.active) {
-        m.loop_start();
-
-        while (SDL_PollEvent(&m.e)) {
-            switch (m.e.type) {
-            case SDL_QUIT:
-                // m.active = false;
-                //printf("Quit Started\n");
-                quitmode = true;
-                quit_scene.quitmode = true;
-                break;
-
-            case SDL_KEYDOWN:
-                switch (m.e.key.keysym.sym) {
-                case SDLK_ESCAPE:
-                    m.active = false;
-                    break;
-                }
-                break;
+    // Application-wide handlers. Scenes still see every event in event().
+    m.events.subscribe(SDL_QUIT, [&](const SDL_Event &e) {
+        quitmode = true;
+        quit_scene.quitmode = true;
+    });
 
-            case SDL_TEXTINPUT:
-                textbuf += m.e.text.text;
-                std::cout << textbuf << std::endl;
-                break;
+    m.events.subscribe_key(SDL_KEYDOWN, SDLK_ESCAPE, [&](const SDL_Event &e) {
+        m.active = false;
+    });
 
-            case SDL_TEXTEDITING:
-                std::cout << "comp: " << m.e.edit.text << std::endl
-                          << "cursor: " << m.e.edit.start << std::endl
-                          << "sel: " << m.e.edit.length << std::endl;
-            }
+    if (trace) {
+        m.events.subscribe_key(SDL_KEYDOWN, SDLK_F12, [&](const SDL_Event &e) {
+            Profiler::write(trace);
+        });
+    }
+
+    m.events.subscribe(SDL_TEXTINPUT, [&](const SDL_Event &e) {
+        textbuf += e.text.text;
+        std::cout << textbuf << std::endl;
+    });
 
-            if (!quitmode) {
-                scene_list[s]->event();
-                quit_scene.event();
-            } else {
-                quit_scene.event();
-                if (quit_scene.quitmode == false) {
-                    quitmode = false;
+    m.events.subscribe(SDL_TEXTEDITING, [&](const SDL_Event &e) {
+        std::cout << "comp: " << e.edit.text << std::endl
+                  << "cursor: " << e.edit.start << std::endl
+                  << "sel: " << e.edit.length << std::endl;
+    });
+
+    while (m.active) {
+        loop.start();
+        PROFILE_FRAME();
+
+        {
+            // One zone for polling and dispatching all of the frame's events.
+            PROFILE_ZONE("Scene::event");
+
+            while (input.poll(&m.e)) {
+                m.events.dispatch(m.e);
+
+                if (!quitmode) {
+                    scene_list[s]->event();
+                    quit_scene.event();
+                } else {
+                    quit_scene.event();
+                    if (quit_scene.quitmode == false) {
+                        quitmode = false;
+                    }
+                    //printf("Quitmode value: %d\n", quitmode);
                 }
-                //printf("Quitmode value: %d\n", quitmode);
+
+                // The next event goes to the scene switched to.
+                switch_scene();
             }
         }
 
-        if (!quitmode)
-            scene_list[s]->update();
-        else
-            quit_scene.update();
+        if (input.get_mode() == InputReplay::MODE_PLAY) {
+            if (input.done())
+                m.active = false;
+            loop.force_steps(input.frame_steps());
+        }
 
-        g.clear();
-        scene_list[s]->draw();
+        loader.upload();
+        m.fps.mark(FPSCounter::PHASE_EVENT);
 
-        std::string p;
-        m.debug_keys["fps"] = "0";
-        for (auto &i :m.debug_keys) {
-            p += i.first + ":" + i.second + " ";
+        while (loop.step()) {
+            PROFILE_ZONE("Scene::update");
+            if (!quitmode)
+                scene_list[s]->update();
+            else
+                quit_scene.update();
         }
 
-        g.text(debug, p);
+        input.end_frame(loop.frame_steps());
+        m.fps.mark(FPSCounter::PHASE_UPDATE);
+
+        g.clear();
+        {
+            PROFILE_ZONE("Scene::draw");
+            scene_list[s]->draw();
+        }
 
-        g.paint(debug);
-        g.paint(text);
+        overlay.set_float(fps_slot, m.get_fps(), 1);
+        overlay.set_int(batches_slot, g.batches_flushed);
+        overlay.set_float(p99_slot, m.fps.histogram_percentile(99));
+        overlay.set_int(draws_slot, g.stats().last.draw_calls());
+        overlay.set_int(switch_slot, g.stats().last.switches);
+        overlay.set_int(target_slot, g.stats().last.targets);
+        overlay.set_int(tex_slot, g.stats().live_textures);
+        overlay.set_int(vram_slot, g.stats().vram / 1024);
+        overlay.draw();
 
         if (quitmode)
             quit_scene.draw();
+
+        m.fps.mark(FPSCounter::PHASE_DRAW);
         g.present();
-        m.loop_end();
+        m.fps.mark(FPSCounter::PHASE_PRESENT);
 
+        loop.end();
+
+        if (++frames == frame_limit)
+            m.active = false;
+    }
+
+    if (headless) {
+        FPSCounter::Percentiles k = m.fps.percentiles();
+        printf("[MAIN] headless: %d frames, p50 %.3f ms, p99 %.3f ms\n",
+               frames, k.p50, k.p99);
     }
+
+    if (trace)
+        Profiler::write(trace);
+
+    if (const char *path = getenv("MEDIA_FRAME_CSV"))
+        m.fps.dump_csv(path);
+
     return 0;
 }
 
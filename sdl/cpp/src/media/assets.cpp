@@ -0,0 +1,297 @@
+#include "media.hpp"
+
+namespace media {
+
+/// Size of a file in bytes, or 0 if it can't be read.
+static size_t file_size(const std::string &path)
+{
+    SDL_RWops *f = SDL_RWFromFile(path.c_str(), "rb");
+    Sint64 k;
+
+    if (!f)
+        return 0;
+
+    k = SDL_RWsize(f);
+    SDL_RWclose(f);
+    return k > 0 ? k : 0;
+}
+
+Assets::Asset::~Asset()
+{
+    if (!shared)
+        destroy_texture(texture);
+    TTF_CloseFont(font);
+    Mix_FreeChunk(sound);
+    Mix_FreeMusic(music);
+}
+
+std::string Assets::key(Kind kind, const std::string &path)
+{
+    static const char *prefix[] = {
+        "texture:", "font:", "sound:", "music:", "sprite:"
+    };
+    return prefix[kind] + path;
+}
+
+Assets::Ref Assets::find(const std::string &key)
+{
+    auto i = assets.find(key);
+
+    if (i == assets.end())
+        return nullptr;
+
+    i->second->last_use = ++use_counter;
+    return i->second;
+}
+
+Assets::Ref Assets::insert(Ref k)
+{
+    k->last_use = ++use_counter;
+    total += k->bytes;
+    assets[k->key] = k;
+    trim();
+    return k;
+}
+
+Assets::Ref Assets::cached(Kind kind, std::string path)
+{
+    return find(key(kind, path));
+}
+
+Assets::Ref Assets::texture(std::string path)
+{
+    Ref k = find(key(ASSET_TEXTURE, path));
+
+    if (k)
+        return k;
+
+    PROFILE_ZONE("Assets::texture");
+    SDL_Surface *t = IMG_Load(path.c_str());
+    if (!t) {
+        printf("Image not loaded: %s\n", path.c_str());
+        return nullptr;
+    }
+
+    Texture *tx = create_texture(m.r, t);
+    Size size = { t->w, t->h };
+    SDL_FreeSurface(t);
+
+    if (!tx) {
+        printf("Image not uploaded: %s\n", path.c_str());
+        return nullptr;
+    }
+
+    return add_texture(path, tx, size);
+}
+
+Assets::Ref Assets::font(std::string path, int size)
+{
+    std::string key = this->key(ASSET_FONT, path) + ":" + std::to_string(size);
+    Ref k = find(key);
+
+    if (k)
+        return k;
+
+    PROFILE_ZONE("Assets::font");
+    TTF_Font *f = TTF_OpenFont(path.c_str(), size);
+    if (!f) {
+        printf("Font not loaded: %s\n", path.c_str());
+        return nullptr;
+    }
+
+    k = std::make_shared<Asset>(ASSET_FONT, key);
+    k->font = f;
+    k->bytes = file_size(path);
+    return insert(k);
+}
+
+Assets::Ref Assets::sound(std::string path)
+{
+    Ref k = find(key(ASSET_SOUND, path));
+
+    if (k)
+        return k;
+
+    PROFILE_ZONE("Assets::sound");
+    SoundData *s = Mix_LoadWAV(path.c_str());
+    if (!s) {
+        printf("Sound not loaded: %s\n", path.c_str());
+        return nullptr;
+    }
+
+    return add_sound(path, s);
+}
+
+Assets::Ref Assets::music(std::string path)
+{
+    Ref k = find(key(ASSET_MUSIC, path));
+
+    if (k)
+        return k;
+
+    PROFILE_ZONE("Assets::music");
+    MusicData *s = Mix_LoadMUS(path.c_str());
+    if (!s) {
+        printf("Music not loaded: %s\n", path.c_str());
+        return nullptr;
+    }
+
+    return add_music(path, s);
+}
+
+Assets::Ref Assets::add_texture(std::string path, Texture *tx, Size size)
+{
+    Ref k = find(key(ASSET_TEXTURE, path));
+
+    if (k) {
+        destroy_texture(tx);
+        return k;
+    }
+
+    k = std::make_shared<Asset>(ASSET_TEXTURE, key(ASSET_TEXTURE, path));
+    k->texture = tx;
+    k->size = size;
+    k->region = (Rect) { 0, 0, size.w, size.h };
+    k->bytes = (size_t) size.w * size.h * 4;
+    return insert(k);
+}
+
+Assets::Ref Assets::add_sound(std::string path, SoundData *s)
+{
+    Ref k = find(key(ASSET_SOUND, path));
+
+    if (k) {
+        Mix_FreeChunk(s);
+        return k;
+    }
+
+    k = std::make_shared<Asset>(ASSET_SOUND, key(ASSET_SOUND, path));
+    k->sound = s;
+    k->bytes = s->alen;
+    return insert(k);
+}
+
+Assets::Ref Assets::add_music(std::string path, MusicData *s)
+{
+    Ref k = find(key(ASSET_MUSIC, path));
+
+    if (k) {
+        Mix_FreeMusic(s);
+        return k;
+    }
+
+    k = std::make_shared<Asset>(ASSET_MUSIC, key(ASSET_MUSIC, path));
+    k->music = s;
+    k->bytes = file_size(path);
+    return insert(k);
+}
+
+Assets::Ref Assets::image(ObjectRef k, std::string path)
+{
+    Ref t = texture(path);
+
+    if (t) {
+        k.set_shared(t->texture);
+        k.set_rect((Rect) {0, 0, t->size.w, t->size.h});
+    }
+
+    return t;
+}
+
+/// Images too big for an atlas page get a texture of their own.
+Assets::Ref Assets::sprite(std::string path)
+{
+    std::string key = this->key(ASSET_SPRITE, path);
+    Ref k = find(key);
+
+    if (k)
+        return k;
+
+    PROFILE_ZONE("Assets::sprite");
+    SDL_Surface *t = IMG_Load(path.c_str());
+    if (!t) {
+        printf("Image not loaded: %s\n", path.c_str());
+        return nullptr;
+    }
+
+    if (!atlas)
+        atlas.reset(new Atlas(m));
+
+    k = std::make_shared<Asset>(ASSET_SPRITE, key);
+    k->size = (Size) { t->w, t->h };
+
+    if (atlas->place(t, k->texture, k->region)) {
+        k->shared = true;
+    } else {
+        k->texture = create_texture(m.r, t);
+        k->region = (Rect) { 0, 0, t->w, t->h };
+        k->bytes = (size_t) t->w * t->h * 4;
+    }
+
+    SDL_FreeSurface(t);
+
+    if (!k->texture) {
+        printf("Image not uploaded: %s\n", path.c_str());
+        return nullptr;
+    }
+
+    return insert(k);
+}
+
+Assets::Ref Assets::image(ClipObjectRef k, std::string path)
+{
+    Ref t = sprite(path);
+
+    if (t)
+        k.set_region(t->texture, t->region);
+
+    return t;
+}
+
+void Assets::set_budget(size_t budget)
+{
+    this->budget = budget;
+    trim();
+}
+
+void Assets::trim()
+{
+    while (total > budget) {
+        auto lru = assets.end();
+
+        for (auto i = assets.begin(); i != assets.end(); i++) {
+            if (i->second.use_count() > 1)
+                continue;
+            if (lru == assets.end() || i->second->last_use < lru->second->last_use)
+                lru = i;
+        }
+
+        // Everything left is in use.
+        if (lru == assets.end())
+            return;
+
+        total -= lru->second->bytes;
+        assets.erase(lru);
+    }
+}
+
+void Assets::purge()
+{
+    for (auto i = assets.begin(); i != assets.end();) {
+        if (i->second.use_count() > 1) {
+            i++;
+            continue;
+        }
+        total -= i->second->bytes;
+        i = assets.erase(i);
+    }
+}
+
+void Assets::clear()
+{
+    assets.clear();
+    atlas.reset();
+    total = 0;
+}
+
+};
@@ -0,0 +1,123 @@
+#ifndef MEDIA_ASSETS_H
+#define MEDIA_ASSETS_H
+
+#include <memory>
+
+#include "common.hpp"
+#include "object.hpp"
+#include "audio.hpp"
+#include "atlas.hpp"
+
+namespace media {
+
+/**
+ * Reference counted asset registry.
+ *
+ * Assets are keyed by kind, path and load parameters, so asking twice for
+ * the same file returns the same data. Handles are shared pointers; when the
+ * registry holds the only reference, the asset is unused but stays cached
+ * until the memory budget is exceeded, then the least recently requested
+ * unused assets are evicted.
+ *
+ * Sizes are estimates: textures count 4 bytes per pixel and samples count
+ * their PCM buffer. Fonts and music count the size of their file, which they
+ * are read from as needed.
+ *
+ * Images loaded into a ClipObject are packed into a shared Atlas, so that
+ * sprites from different files can be batched together. They count as 0:
+ * the atlas pages hold the memory, and are only freed by clear().
+ */
+
+class Assets {
+    public:
+        enum Kind {
+            ASSET_TEXTURE,
+            ASSET_FONT,
+            ASSET_SOUND,
+            ASSET_MUSIC,
+            ASSET_SPRITE  /// Image in the atlas
+        };
+
+        struct Asset {
+            Kind kind;
+            std::string key;
+            size_t bytes        = 0;
+            uint64_t last_use   = 0;
+            Texture *texture    = nullptr;
+            bool shared         = false;  /// Texture is an atlas page
+            Size size           = { 0, 0 };
+            Rect region         = { 0, 0, 0, 0 }; /// Image within texture
+            TTF_Font *font      = nullptr;
+            SoundData *sound    = nullptr;
+            MusicData *music    = nullptr;
+
+            Asset(Kind kind, std::string key): kind(kind), key(key) {}
+            ~Asset();
+        };
+
+        typedef std::shared_ptr<Asset> Ref;
+
+    protected:
+        State &m;
+        std::map<std::string, Ref> assets;
+        std::unique_ptr<Atlas> atlas;  /// Created with the first sprite
+        size_t budget;
+        size_t total = 0;
+        uint64_t use_counter = 0;
+
+        static std::string key(Kind kind, const std::string &path);
+        Ref find(const std::string &key);
+        Ref insert(Ref k);
+        Ref sprite(std::string path);
+
+    public:
+        Assets(State &m, size_t budget = 64 * 1024 * 1024): m(m), budget(budget) {}
+
+        Ref texture(std::string path);
+        Ref font(std::string path, int size);
+        Ref sound(std::string path);
+        Ref music(std::string path);
+
+        /// @return The asset if it is cached, without loading it otherwise.
+        Ref cached(Kind kind, std::string path);
+
+        /// Registers data loaded elsewhere, e.g. by a Loader, and takes
+        /// ownership of it. If the path is cached already, the new data is
+        /// freed and the cached asset returned instead.
+        Ref add_texture(std::string path, Texture *tx, Size size);
+        Ref add_sound(std::string path, SoundData *s);
+        Ref add_music(std::string path, MusicData *s);
+
+        /// Loads an image and points the object at the shared texture. The
+        /// returned handle must be kept for as long as the object is used.
+        Ref image(ObjectRef k, std::string path);
+
+        /// Like the above, but packs the image into the atlas and points the
+        /// object at its region there.
+        Ref image(ClipObjectRef k, std::string path);
+
+        void set_budget(size_t budget);
+
+        /// Evicts unused assets until the total is within budget.
+        void trim();
+
+        /// Evicts every unused asset.
+        void purge();
+
+        /// Drops the registry's references to everything.
+        void clear();
+
+        inline size_t bytes()
+        {
+            return total;
+        }
+
+        inline size_t count()
+        {
+            return assets.size();
+        }
+};
+
+};
+
+#endif
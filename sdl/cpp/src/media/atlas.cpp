@@ -0,0 +1,143 @@
+#include "media.hpp"
+
+namespace media {
+
+Atlas::~Atlas()
+{
+    for (auto &i: pages)
+        destroy_texture(i.texture);
+}
+
+bool Atlas::new_page()
+{
+    Page p;
+
+    p.texture = create_texture(m.r, SDL_PIXELFORMAT_ARGB8888,
+                               SDL_TEXTUREACCESS_STATIC, page_w, page_h);
+    if (!p.texture) {
+        printf("Atlas page not created: %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_SetTextureBlendMode(p.texture, SDL_BLENDMODE_BLEND);
+
+    // Texture contents are undefined on creation; the gaps must be clear.
+    std::vector<uint32_t> blank(page_w * page_h, 0);
+    update_texture(p.texture, nullptr, blank.data(), page_w * sizeof(uint32_t));
+
+    p.free_rects.push_back((Rect) {0, 0, page_w, page_h});
+    pages.push_back(std::move(p));
+    return true;
+}
+
+/**
+ * Finds the free rectangle that wastes the least area, then splits what is
+ * left of it along its longer side.
+ */
+bool Atlas::pack(int w, int h, size_t &page, Rect &region)
+{
+    int pw = w + spacing;
+    int ph = h + spacing;
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        std::vector<Rect> &f = pages[i].free_rects;
+        int best = -1;
+        long best_waste = 0;
+
+        for (size_t j = 0; j < f.size(); j++) {
+            if (f[j].w < pw || f[j].h < ph)
+                continue;
+
+            long waste = (long) f[j].w * f[j].h - (long) pw * ph;
+            if (best < 0 || waste < best_waste) {
+                best = j;
+                best_waste = waste;
+            }
+        }
+
+        if (best < 0)
+            continue;
+
+        Rect r = f[best];
+        Rect right, below;
+
+        if (r.w - pw > r.h - ph) {
+            right = (Rect) { r.x + pw, r.y,      r.w - pw, r.h      };
+            below = (Rect) { r.x,      r.y + ph, pw,       r.h - ph };
+        } else {
+            right = (Rect) { r.x + pw, r.y,      r.w - pw, ph       };
+            below = (Rect) { r.x,      r.y + ph, r.w,      r.h - ph };
+        }
+
+        // Swap-remove the used rectangle and keep the non-empty pieces.
+        f[best] = f.back();
+        f.pop_back();
+
+        if (right.w > 0 && right.h > 0)
+            f.push_back(right);
+        if (below.w > 0 && below.h > 0)
+            f.push_back(below);
+
+        page = i;
+        region = (Rect) { r.x, r.y, w, h };
+        return true;
+    }
+
+    return false;
+}
+
+bool Atlas::place(Surface *s, Texture *&page_tx, Rect &region)
+{
+    size_t page;
+
+    if (s->w + spacing > page_w || s->h + spacing > page_h)
+        return false;
+
+    if (!pack(s->w, s->h, page, region)) {
+        if (!new_page() || !pack(s->w, s->h, page, region))
+            return false;
+    }
+
+    // The region stays taken if this fails; there is no freeing in a page.
+    Surface *c = SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!c) {
+        printf("Image not converted: %s\n", SDL_GetError());
+        return false;
+    }
+
+    update_texture(pages[page].texture, &region, c->pixels, c->pitch);
+    SDL_FreeSurface(c);
+
+    page_tx = pages[page].texture;
+    return true;
+}
+
+void Atlas::add(ClipObjectRef k, Surface *s)
+{
+    Texture *page;
+    Rect region;
+
+    if (place(s, page, region)) {
+        k.set_region(page, region);
+        return;
+    }
+
+    // Too big to share a page; give it its own texture.
+    k.set(create_texture(m.r, s));
+    k.set_rect((Rect) {0, 0, s->w, s->h});
+}
+
+void Atlas::image(ClipObjectRef k, std::string filepath)
+{
+    SDL_Surface *t = IMG_Load(filepath.c_str());
+
+    if (!t) {
+        printf("Image not loaded: %s\n", filepath.c_str());
+        return;
+    }
+
+    add(k, t);
+    SDL_FreeSurface(t);
+}
+
+};
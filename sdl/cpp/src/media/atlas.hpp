@@ -0,0 +1,66 @@
+#ifndef MEDIA_ATLAS_H
+#define MEDIA_ATLAS_H
+
+#include <vector>
+#include <string>
+
+#include "common.hpp"
+#include "object.hpp"
+
+namespace media {
+
+/**
+ * Packs loaded images into a few large textures ("pages").
+ *
+ * Objects made by an atlas refer to a region of a page instead of owning a
+ * texture of their own, so sprites from different files can share a draw
+ * batch. Packing uses a guillotine split: a free rectangle that receives an
+ * image is cut into the space to its right and the space below it.
+ *
+ * @note The atlas owns the pages. It must outlive every object made by it.
+ */
+
+class Atlas {
+    protected:
+        struct Page {
+            Texture *texture;
+            std::vector<Rect> free_rects;
+        };
+
+        State &m;
+        std::vector<Page> pages;
+        int page_w;
+        int page_h;
+        int spacing; /// Gap between images, stops linear filtering bleeding
+
+        bool pack(int w, int h, size_t &page, Rect &region);
+        bool new_page();
+
+    public:
+        Atlas(State &m, int page_w = 1024, int page_h = 1024, int spacing = 1):
+            m(m), page_w(page_w), page_h(page_h), spacing(spacing) {}
+
+        ~Atlas();
+
+        /// Loads an image file into the atlas.
+        void image(ClipObjectRef k, std::string filepath);
+
+        /// Copies a surface into the atlas. The surface is not freed.
+        void add(ClipObjectRef k, Surface *s);
+
+        /**
+         * Copies a surface into a page, without an object to point at it.
+         * @return false if the surface is too big for a page, or copying it
+         *         failed.
+         */
+        bool place(Surface *s, Texture *&page, Rect &region);
+
+        inline size_t page_count()
+        {
+            return pages.size();
+        }
+};
+
+};
+
+#endif
@@ -54,9 +54,12 @@ struct MusicControl {
 
 class Sound : public Audio {
     private:
-        SoundData *data;
+        SoundData *data = nullptr;
+        bool shared = false; /// Data is owned elsewhere, e.g. by Assets
 
     public:
+        Sound() {}
+
         Sound(std::string filepath)
         {
             data = Mix_LoadWAV(filepath.c_str());
@@ -64,7 +67,24 @@ class Sound : public Audio {
 
         ~Sound()
         {
-            Mix_FreeChunk(data);
+            if (!shared)
+                Mix_FreeChunk(data);
+        }
+
+        /// Takes ownership of already loaded sample data.
+        void set(SoundData *data)
+        {
+            if (!shared)
+                Mix_FreeChunk(this->data);
+            this->data = data;
+            this->shared = false;
+        }
+
+        /// Uses sample data owned elsewhere.
+        void set_shared(SoundData *data)
+        {
+            set(data);
+            this->shared = true;
         }
 
         bool fail() { return data == nullptr; }
@@ -88,8 +108,11 @@ class Sound : public Audio {
 class Music : public Audio {
     private:
         MusicData *data = nullptr;
+        bool shared = false; /// Data is owned elsewhere, e.g. by Assets
 
     public:
+        Music() {}
+
         Music(std::string filepath)
         {
             data = Mix_LoadMUS(filepath.c_str());
@@ -97,7 +120,24 @@ class Music : public Audio {
 
         ~Music()
         {
-            Mix_FreeMusic(data);
+            if (!shared)
+                Mix_FreeMusic(data);
+        }
+
+        /// Takes ownership of already loaded music data.
+        void set(MusicData *data)
+        {
+            if (!shared)
+                Mix_FreeMusic(this->data);
+            this->data = data;
+            this->shared = false;
+        }
+
+        /// Uses music data owned elsewhere.
+        void set_shared(MusicData *data)
+        {
+            set(data);
+            this->shared = true;
         }
 
         bool fail() { return data == nullptr; }
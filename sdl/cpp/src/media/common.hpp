@@ -99,6 +99,8 @@ struct Exception {
 };
 
 class State;
+class Graphics;
+class Text;
 
 };
 #endif
@@ -0,0 +1,234 @@
+#include <algorithm>
+
+#include "events.hpp"
+#include "util.hpp"
+
+namespace media {
+
+/* ===== Subscribing ===== */
+
+int EventBus::add(Location k, Entry e)
+{
+    e.id = next_id++;
+    e.enabled = true;
+    e.dead = false;
+    where[e.id] = k;
+
+    // The lists can't change under a running dispatch().
+    if (depth > 0) {
+        pending.push_back(std::make_pair(k, std::move(e)));
+        return next_id - 1;
+    }
+
+    Bucket &b = table[k.type];
+    if (k.has_key)
+        b.keys[k.key].push_back(std::move(e));
+    else
+        b.any.push_back(std::move(e));
+
+    return next_id - 1;
+}
+
+int EventBus::subscribe(uint32_t type, Handler f)
+{
+    return add((Location) { type, false, 0 },
+               (Entry) { 0, false, {0, 0, 0, 0}, true, false, std::move(f) });
+}
+
+int EventBus::subscribe_key(uint32_t type, SDL_Keycode key, Handler f)
+{
+    return add((Location) { type, true, key },
+               (Entry) { 0, false, {0, 0, 0, 0}, true, false, std::move(f) });
+}
+
+int EventBus::subscribe_region(uint32_t type, const Rect &region, Handler f)
+{
+    return add((Location) { type, false, 0 },
+               (Entry) { 0, true, region, true, false, std::move(f) });
+}
+
+EventBus::Entry *EventBus::find(int id)
+{
+    auto w = where.find(id);
+    if (w == where.end())
+        return nullptr;
+
+    for (auto &i: pending) {
+        if (i.second.id == id)
+            return &i.second;
+    }
+
+    auto t = table.find(w->second.type);
+    if (t == table.end())
+        return nullptr;
+
+    std::vector<Entry> *list = &t->second.any;
+    if (w->second.has_key) {
+        auto k = t->second.keys.find(w->second.key);
+        if (k == t->second.keys.end())
+            return nullptr;
+        list = &k->second;
+    }
+
+    for (auto &i: *list) {
+        if (i.id == id)
+            return &i;
+    }
+
+    return nullptr;
+}
+
+void EventBus::unsubscribe(int id)
+{
+    Entry *k = find(id);
+
+    if (k == nullptr)
+        return;
+
+    k->dead = true;
+    where.erase(id);
+    dead = true;
+
+    if (depth == 0)
+        sweep();
+}
+
+void EventBus::enable(int id, bool k)
+{
+    Entry *e = find(id);
+    if (e)
+        e->enabled = k;
+}
+
+void EventBus::set_region(int id, const Rect &region)
+{
+    Entry *e = find(id);
+    if (e)
+        e->region = region;
+}
+
+/// Removes dead entries and files subscriptions made during dispatch.
+void EventBus::sweep()
+{
+    auto is_dead = [](const Entry &e) {
+        return e.dead;
+    };
+
+    if (dead) {
+        for (auto &t: table) {
+            auto &any = t.second.any;
+            any.erase(std::remove_if(any.begin(), any.end(), is_dead), any.end());
+
+            for (auto &k: t.second.keys) {
+                auto &list = k.second;
+                list.erase(std::remove_if(list.begin(), list.end(), is_dead), list.end());
+            }
+        }
+        dead = false;
+    }
+
+    for (auto &i: pending) {
+        if (i.second.dead)
+            continue;
+
+        Bucket &b = table[i.first.type];
+        if (i.first.has_key)
+            b.keys[i.first.key].push_back(std::move(i.second));
+        else
+            b.any.push_back(std::move(i.second));
+    }
+
+    pending.clear();
+}
+
+/* ===== Dispatching ===== */
+
+static bool event_point(const SDL_Event &e, Point &p)
+{
+    switch (e.type) {
+    case SDL_MOUSEMOTION:
+        p = (Point) { e.motion.x, e.motion.y };
+        return true;
+
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        p = (Point) { e.button.x, e.button.y };
+        return true;
+    }
+
+    return false;
+}
+
+bool EventBus::run(std::vector<Entry> &list, const SDL_Event &e,
+                   bool has_point, Point p)
+{
+    bool ran = false;
+
+    // Indexed, as handlers may queue subscriptions; the list itself stays put.
+    for (size_t i = 0; i < list.size(); i++) {
+        Entry &k = list[i];
+
+        if (k.dead || !k.enabled)
+            continue;
+        if (k.has_region && !(has_point && util::point_in_rect(p.x, p.y, k.region)))
+            continue;
+
+        k.f(e);
+        ran = true;
+    }
+
+    return ran;
+}
+
+bool EventBus::dispatch(const SDL_Event &e)
+{
+    auto t = table.find(e.type);
+    if (t == table.end())
+        return false;
+
+    Bucket &b = t->second;
+    Point p;
+    bool has_point = event_point(e, p);
+    bool ran = false;
+
+    depth++;
+
+    if (!b.keys.empty() && (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP)) {
+        auto k = b.keys.find(e.key.keysym.sym);
+        if (k != b.keys.end())
+            ran = run(k->second, e, has_point, p);
+    }
+
+    ran = run(b.any, e, has_point, p) || ran;
+
+    if (--depth == 0 && (dead || !pending.empty()))
+        sweep();
+
+    return ran;
+}
+
+void EventBus::clear()
+{
+    if (depth > 0) {
+        // Can't free handlers that may be running; let sweep() drop them.
+        for (auto &t: table) {
+            for (auto &i: t.second.any)
+                i.dead = true;
+            for (auto &k: t.second.keys) {
+                for (auto &i: k.second)
+                    i.dead = true;
+            }
+        }
+        pending.clear();
+        where.clear();
+        dead = true;
+        return;
+    }
+
+    table.clear();
+    where.clear();
+    pending.clear();
+    dead = false;
+}
+
+};
@@ -0,0 +1,96 @@
+#ifndef MEDIA_EVENTS_H
+#define MEDIA_EVENTS_H
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include <cstdint>
+#include <SDL2/SDL.h>
+
+#include "common.hpp"
+
+namespace media {
+
+/**
+ * Table-driven event dispatch.
+ *
+ * Handlers subscribe to one event type, optionally narrowed down to a key
+ * code or a region of the window. dispatch() looks the event's type up in a
+ * table, and key events their key code in a second one, so only handlers
+ * that could match are visited. An event nobody subscribed to costs a single
+ * lookup.
+ *
+ *     int id = m.events.subscribe_key(SDL_KEYUP, SDLK_SPACE,
+ *         [&](const SDL_Event &e) { s = SCENE_GAME; });
+ *
+ * Region subscriptions only match events that carry a mouse position:
+ * motion and button presses.
+ *
+ * Handlers may subscribe and unsubscribe, themselves included, while being
+ * dispatched to. New subscriptions take effect with the next event.
+ */
+
+class EventBus {
+    public:
+        typedef std::function<void (const SDL_Event &)> Handler;
+
+    protected:
+        struct Entry {
+            int id;
+            bool has_region;
+            Rect region;
+            bool enabled;
+            bool dead;
+            Handler f;
+        };
+
+        struct Bucket {
+            std::vector<Entry> any;  /// Type only, or type and region
+            std::unordered_map<SDL_Keycode, std::vector<Entry>> keys;
+        };
+
+        struct Location {
+            uint32_t type;
+            bool has_key;
+            SDL_Keycode key;
+        };
+
+        std::unordered_map<uint32_t, Bucket> table;
+        std::unordered_map<int, Location> where;
+        std::vector<std::pair<Location, Entry>> pending;
+        int next_id = 1;
+        int depth = 0;      /// Nesting of dispatch() calls
+        bool dead = false;  /// Entries wait to be swept
+
+        int add(Location k, Entry e);
+        Entry *find(int id);
+        void sweep();
+        static bool run(std::vector<Entry> &list, const SDL_Event &e,
+                        bool has_point, Point p);
+
+    public:
+        EventBus() {}
+
+        /// @return Subscription id, for unsubscribe() and the like.
+        int subscribe(uint32_t type, Handler f);
+        int subscribe_key(uint32_t type, SDL_Keycode key, Handler f);
+        int subscribe_region(uint32_t type, const Rect &region, Handler f);
+
+        void unsubscribe(int id);
+
+        /// Disabled subscriptions stay in place but are skipped.
+        void enable(int id, bool k);
+
+        /// Moves a region subscription.
+        void set_region(int id, const Rect &region);
+
+        /// @return true if any handler ran.
+        bool dispatch(const SDL_Event &e);
+
+        void clear();
+};
+
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include <algorithm>
+
+#include "fps.hpp"
+
+namespace media {
+
+int FPSCounter::bin(uint64_t ticks)
+{
+    uint64_t k = ticks * 1000000 / freq / BIN_US;
+    return k < HISTOGRAM_BINS ? k : HISTOGRAM_BINS - 1;
+}
+
+void FPSCounter::push(const Frame &f)
+{
+    if (count == HISTORY)
+        histogram[bin(frames[head].total)]--;
+    else
+        count++;
+
+    frames[head] = f;
+    histogram[bin(f.total)]++;
+    head = (head + 1) % HISTORY;
+}
+
+/// @param phase Phase index, or -1 for whole frames.
+FPSCounter::Percentiles FPSCounter::compute(int phase)
+{
+    Percentiles k = { 0, 0, 0, 0 };
+
+    if (count == 0)
+        return k;
+
+    for (int i = 0; i < count; i++)
+        scratch[i] = phase < 0 ? frames[i].total : frames[i].phase[phase];
+
+    std::sort(scratch, scratch + count);
+
+    k.p50 = to_ms(scratch[(count - 1) * 50 / 100]);
+    k.p95 = to_ms(scratch[(count - 1) * 95 / 100]);
+    k.p99 = to_ms(scratch[(count - 1) * 99 / 100]);
+    k.max = to_ms(scratch[count - 1]);
+    return k;
+}
+
+FPSCounter::Percentiles FPSCounter::percentiles()
+{
+    return compute(-1);
+}
+
+FPSCounter::Percentiles FPSCounter::percentiles(Phase p)
+{
+    return compute(p);
+}
+
+float FPSCounter::histogram_percentile(int percent)
+{
+    // Same rank as compute() picks, counted from 1.
+    int rank = (count - 1) * percent / 100 + 1;
+    int seen = 0;
+
+    if (count == 0)
+        return 0;
+
+    for (int i = 0; i < HISTOGRAM_BINS; i++) {
+        seen += histogram[i];
+        if (seen < rank)
+            continue;
+
+        // The last bin also holds everything slower; give its lower edge.
+        int edge = i < HISTOGRAM_BINS - 1 ? i + 1 : i;
+        return edge * BIN_US / 1000.0f;
+    }
+
+    return 0;
+}
+
+bool FPSCounter::dump_csv(const char *path)
+{
+    FILE *f = fopen(path, "w");
+
+    if (!f)
+        return false;
+
+    fputs("frame,total_ms,event_ms,update_ms,draw_ms,present_ms,pacing_ms\n", f);
+
+    for (int i = count - 1; i >= 0; i--) {
+        const Frame &k = frame(i);
+        uint64_t work = 0;
+
+        for (int j = 0; j < PHASE_COUNT; j++)
+            work += k.phase[j];
+
+        fprintf(f, "%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                count - 1 - i,
+                to_ms(k.total),
+                to_ms(k.phase[PHASE_EVENT]),
+                to_ms(k.phase[PHASE_UPDATE]),
+                to_ms(k.phase[PHASE_DRAW]),
+                to_ms(k.phase[PHASE_PRESENT]),
+                to_ms(k.total > work ? k.total - work : 0));
+    }
+
+    fclose(f);
+    return true;
+}
+
+};
@@ -0,0 +1,121 @@
+#ifndef MEDIA_FPS_H
+#define MEDIA_FPS_H
+
+#include "common.hpp"
+
+namespace media {
+
+/**
+ * Frame timing statistics.
+ *
+ * The last HISTORY frames are kept in a ring buffer, split into phases by
+ * calling mark() as each phase of the frame ends. Time not covered by any
+ * phase is pacing (sleeping or waiting on vsync). A histogram of whole frame
+ * times is maintained as frames enter and leave the ring.
+ *
+ * All timestamps are in performance counter ticks; query results are in
+ * milliseconds. Nothing allocates per frame.
+ */
+
+struct FPSCounter {
+    enum Phase {
+        PHASE_EVENT,
+        PHASE_UPDATE,
+        PHASE_DRAW,
+        PHASE_PRESENT,
+        PHASE_COUNT
+    };
+
+    static const int HISTORY        = 512;
+    static const int HISTOGRAM_BINS = 64;
+    static const int BIN_US         = 500; /// Width of a histogram bin
+
+    struct Frame {
+        uint64_t total;
+        uint64_t phase[PHASE_COUNT];
+    };
+
+    struct Percentiles {
+        float p50;
+        float p95;
+        float p99;
+        float max;
+    };
+
+    uint64_t start   = 0; /// Start of the current frame
+    uint64_t end     = 0; /// End of the current frame's work
+    uint64_t elapsed = 0; /// Work time of the current frame
+    float value      = 0; /// Instantaneous FPS
+    uint64_t freq    = SDL_GetPerformanceFrequency();
+
+    Frame frames[HISTORY];
+    int head  = 0; /// Next slot to write
+    int count = 0;
+    uint32_t histogram[HISTOGRAM_BINS] = { 0 };
+
+    /// Commits the previous frame, if any, and starts a new one at now.
+    inline void begin(uint64_t now);
+
+    /// Ends the given phase of the current frame.
+    inline void mark(Phase p);
+
+    Percentiles percentiles();
+    Percentiles percentiles(Phase p);
+
+    /**
+     * Whole frame percentile read off the histogram: the upper edge of the
+     * bin it falls in, so only as precise as BIN_US. Unlike percentiles(),
+     * which sorts the history, it is cheap enough to call every frame.
+     */
+    float histogram_percentile(int percent);
+
+    inline const Frame &frame(int age); /// 0 is the latest complete frame
+    inline float to_ms(uint64_t ticks);
+    int bin(uint64_t ticks);
+
+    /// Writes the frame history to a CSV file, oldest first.
+    bool dump_csv(const char *path);
+
+    protected:
+        Frame current = Frame();
+        uint64_t last_mark = 0;
+        uint64_t scratch[HISTORY];
+
+        void push(const Frame &f);
+        Percentiles compute(int phase);
+};
+
+inline void FPSCounter::begin(uint64_t now)
+{
+    if (start != 0) {
+        current.total = now - start;
+        if (current.total > 0)
+            value = freq / (float) current.total;
+        push(current);
+    }
+
+    current = Frame();
+    start = now;
+    last_mark = now;
+}
+
+inline void FPSCounter::mark(Phase p)
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+    current.phase[p] += now - last_mark;
+    last_mark = now;
+}
+
+inline const FPSCounter::Frame &FPSCounter::frame(int age)
+{
+    return frames[(head - 1 - age + HISTORY) % HISTORY];
+}
+
+inline float FPSCounter::to_ms(uint64_t ticks)
+{
+    return ticks * 1000.0f / freq;
+}
+
+};
+
+#endif
@@ -1,9 +1,14 @@
+#include <algorithm>
+#include <cstdlib>
+
 #include "graphics.hpp"
+#include "profile.hpp"
 
 namespace media {
 
 void Graphics::text(ObjectRef k, const char *str, Color c)
 {
+    PROFILE_ZONE("Graphics::text");
     Rect dims;
     SDL_Surface *t;
 
@@ -19,7 +24,7 @@ void Graphics::text(ObjectRef k, const char *str, Color c)
     //printf("LABELMAKE\n");
     //PRINTRECT(dims);
     k.set_rect(dims);
-    Texture *ttx = SDL_CreateTextureFromSurface(this->m.r, t);
+    Texture *ttx = create_texture(this->m.r, t);
     SDL_FreeSurface(t);
     k.set(ttx);
 }
@@ -42,7 +47,7 @@ void Graphics::text(ObjectRef k, std::string str)
 void Graphics::image(ObjectRef k, std::string filepath)
 {
     SDL_Surface *t = IMG_Load(filepath.c_str());
-    SDL_Texture *ttx = SDL_CreateTextureFromSurface(m.r, t);
+    SDL_Texture *ttx = create_texture(m.r, t);
     Rect dims;
     
     SDL_GetClipRect(t, &dims);
@@ -52,4 +57,290 @@ void Graphics::image(ObjectRef k, std::string filepath)
     SDL_FreeSurface(t);
 }
 
+/*
+ * =============================================================================
+ * Batching
+ * =============================================================================
+ */
+
+void Graphics::batch(bool enable)
+{
+    if (!enable)
+        flush();
+    batch_flag = enable;
+}
+
+void Graphics::batch_quad(Texture *tx, const Rect *src, const Rect *dest, Color mod)
+{
+    if (tx == nullptr)
+        return;
+
+    if (tx != batch_tx) {
+        if (!batch_indices.empty())
+            flush_batch();
+        batch_tx = tx;
+        SDL_QueryTexture(tx, nullptr, nullptr, &batch_tx_w, &batch_tx_h);
+    }
+
+    Rect d;
+    if (dest) {
+        d = *dest;
+    } else {
+        Size t = target_size();
+        d = (Rect) {0, 0, t.w, t.h};
+    }
+
+    float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+    if (src) {
+        u0 = src->x / (float) batch_tx_w;
+        v0 = src->y / (float) batch_tx_h;
+        u1 = (src->x + src->w) / (float) batch_tx_w;
+        v1 = (src->y + src->h) / (float) batch_tx_h;
+    }
+
+    float x0 = d.x, y0 = d.y, x1 = d.x + d.w, y1 = d.y + d.h;
+    int base = batch_vertices.size();
+
+    batch_vertices.push_back((SDL_Vertex) { {x0, y0}, mod, {u0, v0} });
+    batch_vertices.push_back((SDL_Vertex) { {x1, y0}, mod, {u1, v0} });
+    batch_vertices.push_back((SDL_Vertex) { {x1, y1}, mod, {u1, v1} });
+    batch_vertices.push_back((SDL_Vertex) { {x0, y1}, mod, {u0, v1} });
+
+    batch_indices.push_back(base + 0);
+    batch_indices.push_back(base + 1);
+    batch_indices.push_back(base + 2);
+    batch_indices.push_back(base + 0);
+    batch_indices.push_back(base + 2);
+    batch_indices.push_back(base + 3);
+}
+
+void Graphics::flush_batch()
+{
+    render_stats().geometry(batch_tx);
+    SDL_RenderGeometry(m.r, batch_tx,
+                       batch_vertices.data(), batch_vertices.size(),
+                       batch_indices.data(), batch_indices.size());
+    batch_count++;
+
+    // clear() keeps the capacity, so steady-state frames don't allocate.
+    batch_vertices.clear();
+    batch_indices.clear();
+    batch_tx = nullptr;
+}
+
+/*
+ * =============================================================================
+ * Deferred Drawing
+ * =============================================================================
+ */
+
+static inline bool same_color(Color a, Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+/// Area touched by a command, at least one pixel in each direction.
+static inline Rect bounds(const DrawCommand &k)
+{
+    if (k.type == DrawCommand::CMD_LINE) {
+        return (Rect) {
+            std::min(k.dest.x, k.dest.w),
+            std::min(k.dest.y, k.dest.h),
+            std::abs(k.dest.w - k.dest.x) + 1,
+            std::abs(k.dest.h - k.dest.y) + 1
+        };
+    }
+
+    return (Rect) { k.dest.x, k.dest.y, std::max(k.dest.w, 1), std::max(k.dest.h, 1) };
+}
+
+void Graphics::defer(bool enable)
+{
+    if (!enable && defer_flag) {
+        flush();
+        defer_flag = false;
+        // The renderer only saw the colours used during replay.
+        set_color(draw_color);
+        return;
+    }
+
+    // Whatever was batched so far must not end up under what is recorded.
+    if (enable && !defer_flag)
+        flush();
+
+    defer_flag = enable;
+}
+
+int Graphics::record(DrawCommand::Type type, const Rect &dest)
+{
+    DrawCommand k;
+
+    k.type    = type;
+    k.layer   = layer;
+    k.run     = 0;
+    k.seq     = commands.size();
+    k.texture = nullptr;
+    k.color   = draw_color;
+    k.has_src = false;
+    k.dest    = dest;
+
+    k.dest.x -= origin.x;
+    k.dest.y -= origin.y;
+
+    // Lines store their second end point in w and h.
+    if (type == DrawCommand::CMD_LINE) {
+        k.dest.w -= origin.x;
+        k.dest.h -= origin.y;
+    }
+
+    commands.push_back(k);
+    return 0;
+}
+
+void Graphics::record_copy(Texture *tx, const Rect *src, const Rect *dest, Color mod)
+{
+    DrawCommand k;
+
+    if (tx == nullptr)
+        return;
+
+    k.type    = DrawCommand::CMD_COPY;
+    k.layer   = layer;
+    k.run     = 0;
+    k.seq     = commands.size();
+    k.texture = tx;
+    k.color   = mod;
+    k.has_src = src != nullptr;
+
+    if (src)
+        k.src = *src;
+
+    if (dest) {
+        k.dest = shift(*dest);
+    } else {
+        Size t = target_size();
+        k.dest = (Rect) {0, 0, t.w, t.h};
+    }
+
+    commands.push_back(k);
+}
+
+/**
+ * Replays recorded commands, lowest layer first.
+ *
+ * Within a layer, each command is merged into the most recent earlier run
+ * with the same state (type and colour, or texture for copies), provided it
+ * doesn't overlap anything drawn in between. The result is identical to
+ * drawing in call order, with far fewer state changes and renderer calls.
+ */
+void Graphics::replay()
+{
+    std::sort(commands.begin(), commands.end(),
+        [](const DrawCommand &a, const DrawCommand &b) {
+            return a.layer != b.layer ? a.layer < b.layer : a.seq < b.seq;
+        });
+
+    runs.clear();
+
+    for (auto &k: commands) {
+        Rect b = bounds(k);
+        int target = -1;
+
+        for (int i = runs.size() - 1, n = 0; i >= 0 && n < RUN_LOOKBACK; i--, n++) {
+            Run &r = runs[i];
+
+            if (r.layer != k.layer)
+                break;
+
+            if (r.type == k.type &&
+                (k.type == DrawCommand::CMD_COPY ? r.texture == k.texture
+                                                 : same_color(r.color, k.color))) {
+                target = i;
+                break;
+            }
+
+            // Can't be moved behind something it overlaps.
+            if (util::rects_overlap(r.bounds, b))
+                break;
+        }
+
+        if (target < 0) {
+            runs.push_back((Run) { k.type, k.texture, k.color, k.layer, b });
+            target = runs.size() - 1;
+        } else {
+            runs[target].bounds = util::rect_union(runs[target].bounds, b);
+        }
+
+        k.run = target;
+    }
+
+    std::sort(commands.begin(), commands.end(),
+        [](const DrawCommand &a, const DrawCommand &b) {
+            return a.run != b.run ? a.run < b.run : a.seq < b.seq;
+        });
+
+    Color current = {0, 0, 0, 0};
+    bool color_set = false;
+    size_t i = 0;
+
+    while (i < commands.size()) {
+        size_t j = i;
+        const DrawCommand &k = commands[i];
+
+        while (j < commands.size() && commands[j].run == k.run)
+            j++;
+
+        if (k.type != DrawCommand::CMD_COPY &&
+            (!color_set || !same_color(current, k.color))) {
+            render_stats().color();
+            SDL_SetRenderDrawColor(m.r, k.color.r, k.color.g, k.color.b, k.color.a);
+            current = k.color;
+            color_set = true;
+        }
+
+        switch (k.type) {
+        case DrawCommand::CMD_FILL:
+        case DrawCommand::CMD_RECT:
+            run_rects.clear();
+            for (size_t t = i; t < j; t++)
+                run_rects.push_back(commands[t].dest);
+
+            render_stats().primitive();
+            if (k.type == DrawCommand::CMD_FILL)
+                SDL_RenderFillRects(m.r, run_rects.data(), run_rects.size());
+            else
+                SDL_RenderDrawRects(m.r, run_rects.data(), run_rects.size());
+            break;
+
+        case DrawCommand::CMD_POINT:
+            run_points.clear();
+            for (size_t t = i; t < j; t++)
+                run_points.push_back((Point) { commands[t].dest.x, commands[t].dest.y });
+            render_stats().primitive();
+            SDL_RenderDrawPoints(m.r, run_points.data(), run_points.size());
+            break;
+
+        case DrawCommand::CMD_LINE:
+            for (size_t t = i; t < j; t++) {
+                const Rect &l = commands[t].dest;
+                render_stats().primitive();
+                SDL_RenderDrawLine(m.r, l.x, l.y, l.w, l.h);
+            }
+            break;
+
+        case DrawCommand::CMD_COPY:
+            for (size_t t = i; t < j; t++) {
+                const DrawCommand &c = commands[t];
+                batch_quad(c.texture, c.has_src ? &c.src : nullptr, &c.dest, c.color);
+            }
+            flush_batch();
+            break;
+        }
+
+        i = j;
+    }
+
+    commands.clear();
+}
+
 };
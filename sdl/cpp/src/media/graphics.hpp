@@ -12,13 +12,89 @@
 
 #include "common.hpp"
 #include "object.hpp"
+#include "stats.hpp"
 #include "state.hpp"
 
 namespace media {
 
+/// A recorded draw call. Lines keep their end points in dest as x1, y1, x2, y2.
+struct DrawCommand {
+    enum Type {
+        CMD_FILL,
+        CMD_RECT,
+        CMD_LINE,
+        CMD_POINT,
+        CMD_COPY
+    };
+
+    Type type;
+    int layer;
+    int run;
+    uint32_t seq;
+    Texture *texture;
+    Color color; /// Draw colour, or colour mod for copies
+    bool has_src;
+    Rect src;
+    Rect dest;
+};
+
 class Graphics {
     protected:
         State &m;
+        Color draw_color = {0, 0, 0, 255};
+        Texture *target = nullptr; /// Current paint target, null for the window
+        Point origin = {0, 0};     /// See set_origin()
+        bool clip_flag = false;
+        Rect clip_rect;            /// Clip rectangle in target coordinates
+
+        inline Rect shift(const Rect &k);
+
+        // Bulk primitives drawn away from the origin are shifted into these.
+        std::vector<Point> scratch_points;
+        std::vector<Rect> scratch_rects;
+
+        inline const Point *shift_all(const Point *k, int count);
+        inline const Rect *shift_all(const Rect *k, int count);
+        inline Size target_size();
+
+        // Sprite batching. Consecutive paints that share a texture are
+        // gathered as quads and submitted in a single SDL_RenderGeometry call.
+        bool batch_flag = false;
+        Texture *batch_tx = nullptr;
+        int batch_tx_w = 0;
+        int batch_tx_h = 0;
+        int batch_count = 0;
+        std::vector<SDL_Vertex> batch_vertices;
+        std::vector<int> batch_indices;
+
+        void batch_quad(Texture *tx, const Rect *src, const Rect *dest, Color mod);
+        void flush_batch();
+
+        inline void copy(Texture *tx, const Rect *src, const Rect *dest);
+        inline void copy(Texture *tx, const Rect *src, const Rect *dest, Color mod);
+
+        // Deferred mode. Draw calls are recorded with the current layer and
+        // replayed at flush time, grouped by state.
+        struct Run {
+            DrawCommand::Type type;
+            Texture *texture;
+            Color color;
+            int layer;
+            Rect bounds;
+        };
+
+        static const int RUN_LOOKBACK = 16;
+
+        bool defer_flag = false;
+        int layer = 0;
+        std::vector<DrawCommand> commands;
+        std::vector<Run> runs;
+        std::vector<Rect> run_rects;
+        std::vector<Point> run_points;
+
+        int record(DrawCommand::Type type, const Rect &dest);
+        void record_copy(Texture *tx, const Rect *src, const Rect *dest, Color mod);
+        void replay();
 
     public:
         /*
@@ -35,23 +111,63 @@ class Graphics {
         inline void paint(const ObjectRef k, const Rect &src);
         inline void paint(const ObjectRef k);
         inline void paint(const ClipObjectRef k);
+        inline void paint(const ClipObjectRef k, Color mod); /// Tinted paint
+        inline void paint(Texture *tx, const Rect &src, const Rect &dest, Color mod);
 
         inline void paint_clip(const ObjectRef k, const Rect &src);
 
         inline int set_color(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
         inline int set_color(Color c);
+        inline Color get_color();
 
         inline int set_paint_target(const ObjectRef k); /// Set render target
+        inline int set_paint_target(Texture *tx);
+        inline int reset_paint_target(); /// Paint to the window again
+        inline Texture *get_paint_target();
+
+        /// Point of the paint target that coordinates are relative to. Lets a
+        /// subtree laid out in window coordinates be painted into a texture.
+        inline void set_origin(Point p);
+        inline Point get_origin();
+
         inline void clear();   /// Called at start of draw loop
+        inline void clear(Color c);
+        inline void clear(Color c, const Rect &k); /// Overwrite k, alpha included
+
+        /// Restrict painting to k, relative to the origin. Null to disable.
+        /// Changing the paint target disables clipping.
+        inline void set_clip(const Rect *k);
+        inline bool get_clip(Rect &k); /// False if clipping is disabled
         inline void present(); /// Called at end of draw loop
 
+        /// Renderer counters; see RenderStats. Reset by present().
+        inline const RenderStats &stats();
+
+        // Batching
+
+        /// Number of batches submitted during the last presented frame.
+        int batches_flushed = 0;
+
+        void batch(bool enable);   /// Enable or disable sprite batching
+        inline bool batching();
+        inline void flush();       /// Submit any pending quads and commands
+
+        // Deferred drawing
+
+        void defer(bool enable);   /// Enable or disable the command buffer
+        inline bool deferring();
+
+        /// Layer of subsequent draw calls. Lower layers are drawn first.
+        inline void set_layer(int z);
+        inline int get_layer();
+
         // Graphics Primitives
 
         inline int point(int x, int y);
         inline int points(const Point *points, int count);
         inline int points(const std::vector<Point> &points);
 
-        inline int line(int x1, int x2, int y1, int y2);
+        inline int line(int x1, int y1, int x2, int y2);
         inline int line(const Rect dims);
         inline int lines(const Point *points, int count);
         inline int lines(const std::vector<Point> &points);
@@ -74,126 +190,413 @@ class Graphics {
         void image(ObjectRef k, std::string filepath);
 };
 
+inline Rect Graphics::shift(const Rect &k)
+{
+    return (Rect) { k.x - origin.x, k.y - origin.y, k.w, k.h };
+}
+
+/// Size of the current paint target, the window if none is set.
+inline Size Graphics::target_size()
+{
+    Size k = { 0, 0 };
+
+    if (target)
+        SDL_QueryTexture(target, nullptr, nullptr, &k.w, &k.h);
+    else
+        SDL_GetRendererOutputSize(m.r, &k.w, &k.h);
+    return k;
+}
+
+inline void Graphics::copy(Texture *tx, const Rect *src, const Rect *dest)
+{
+    Rect d;
+
+    if (defer_flag) {
+        record_copy(tx, src, dest, (Color) {255, 255, 255, 255});
+        return;
+    }
+
+    if (dest && (origin.x || origin.y)) {
+        d = shift(*dest);
+        dest = &d;
+    }
+
+    if (batch_flag) {
+        batch_quad(tx, src, dest, (Color) {255, 255, 255, 255});
+    } else {
+        render_stats().copy(tx);
+        SDL_RenderCopy(m.r, tx, src, dest);
+    }
+}
+
+inline void Graphics::copy(Texture *tx, const Rect *src, const Rect *dest, Color mod)
+{
+    Rect d;
+
+    if (defer_flag) {
+        record_copy(tx, src, dest, mod);
+        return;
+    }
+
+    if (dest && (origin.x || origin.y)) {
+        d = shift(*dest);
+        dest = &d;
+    }
+
+    if (batch_flag) {
+        batch_quad(tx, src, dest, mod);
+    } else {
+        // Alpha too, as the batched vertex colours would.
+        render_stats().copy(tx);
+        SDL_SetTextureColorMod(tx, mod.r, mod.g, mod.b);
+        SDL_SetTextureAlphaMod(tx, mod.a);
+        SDL_RenderCopy(m.r, tx, src, dest);
+        SDL_SetTextureColorMod(tx, 255, 255, 255);
+        SDL_SetTextureAlphaMod(tx, 255);
+    }
+}
+
 inline void Graphics::paint(const ObjectRef k, const Rect &src, const Rect &dest)
 {
-    SDL_RenderCopy(m.r, k.texture, &src, &dest);
+    copy(k.texture, &src, &dest);
 }
 
 inline void Graphics::paint(const ObjectRef k, const Rect &src)
 {
-    SDL_RenderCopy(m.r, k.texture, &src, &k.dest_rect);
+    copy(k.texture, &src, &k.dest_rect);
 }
 
 inline void Graphics::paint(const ObjectRef k)
 {
     // PRINT_LINE
     // printf("** %lx\n", (unsigned long int) k.texture);
-    SDL_RenderCopy(m.r, k.texture, nullptr, &k.dest_rect);
+    copy(k.texture, nullptr, &k.dest_rect);
 }
 
 inline void Graphics::paint(const ClipObjectRef k)
 {
     // PRINT_LINE
     // printf("** %lx\n", (unsigned long int) k.texture);
-    SDL_RenderCopy(m.r, k.texture, k.src_rect_ptr, &k.dest_rect);
+    copy(k.texture, k.src_rect_ptr, &k.dest_rect);
+}
+
+inline void Graphics::paint(const ClipObjectRef k, Color mod)
+{
+    copy(k.texture, k.src_rect_ptr, &k.dest_rect, mod);
+}
+
+/// Paints part of a raw texture, e.g. a glyph from a Text cache.
+inline void Graphics::paint(Texture *tx, const Rect &src, const Rect &dest, Color mod)
+{
+    copy(tx, &src, &dest, mod);
 }
 
 /// Clip the object to the bounding rectangle's dimensions.
 inline void Graphics::paint_clip(const ObjectRef k, const Rect &src)
 {
     Rect self_clip = { 0, 0, src.w, src.h }; 
-    SDL_RenderCopy(m.r, k.texture, &self_clip, &k.dest_rect);
+    copy(k.texture, &self_clip, &k.dest_rect);
 }
 
 inline int Graphics::set_color(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 {
-    return SDL_SetRenderDrawColor(m.r, r, g, b, a);
+    return set_color((Color) {r, g, b, a});
 }
 
+/// In deferred mode the colour is only recorded with later commands.
 inline int Graphics::set_color(Color c)
 {
+    draw_color = c;
+    if (defer_flag)
+        return 0;
+    render_stats().color();
     return SDL_SetRenderDrawColor(m.r, c.r, c.g, c.b, c.a);
 }
 
+inline Color Graphics::get_color()
+{
+    return draw_color;
+}
+
 inline int Graphics::set_paint_target(const ObjectRef k)
 {
-    return SDL_SetRenderTarget(m.r, k.texture);
+    return set_paint_target(k.texture);
+}
+
+inline int Graphics::set_paint_target(Texture *tx)
+{
+    flush();
+    target = tx;
+    clip_flag = false;
+    render_stats().target();
+
+    int ret = SDL_SetRenderTarget(m.r, tx);
+    SDL_RenderSetClipRect(m.r, nullptr);
+    return ret;
+}
+
+inline int Graphics::reset_paint_target()
+{
+    return set_paint_target((Texture *) nullptr);
+}
+
+inline Texture *Graphics::get_paint_target()
+{
+    return target;
+}
+
+inline void Graphics::set_origin(Point p)
+{
+    origin = p;
+}
+
+inline Point Graphics::get_origin()
+{
+    return origin;
 }
 
 inline void Graphics::clear()
 {
-    set_color(0, 0, 0, 255);
+    clear((Color) {0, 0, 0, 255});
+}
+
+/// Clears the whole paint target, e.g. to transparent for a cached layer.
+inline void Graphics::clear(Color c)
+{
+    flush();
+    draw_color = c;
+    render_stats().color();
+    render_stats().primitive();
+    SDL_SetRenderDrawColor(m.r, c.r, c.g, c.b, c.a);
     SDL_RenderClear(m.r);
 }
 
+/// SDL_RenderClear ignores the clip rectangle, so parts of a target are
+/// cleared with an unblended fill instead.
+inline void Graphics::clear(Color c, const Rect &k)
+{
+    SDL_BlendMode prev;
+    Rect r = shift(k);
+
+    flush();
+    draw_color = c;
+    SDL_GetRenderDrawBlendMode(m.r, &prev);
+    SDL_SetRenderDrawBlendMode(m.r, SDL_BLENDMODE_NONE);
+    render_stats().color();
+    render_stats().primitive();
+    SDL_SetRenderDrawColor(m.r, c.r, c.g, c.b, c.a);
+    SDL_RenderFillRect(m.r, &r);
+    SDL_SetRenderDrawBlendMode(m.r, prev);
+}
+
+inline void Graphics::set_clip(const Rect *k)
+{
+    flush();
+
+    if (k == nullptr) {
+        clip_flag = false;
+        SDL_RenderSetClipRect(m.r, nullptr);
+        return;
+    }
+
+    clip_flag = true;
+    clip_rect = shift(*k);
+    SDL_RenderSetClipRect(m.r, &clip_rect);
+}
+
+inline bool Graphics::get_clip(Rect &k)
+{
+    k = (Rect) { clip_rect.x + origin.x, clip_rect.y + origin.y,
+                 clip_rect.w, clip_rect.h };
+    return clip_flag;
+}
+
 inline void Graphics::present()
 {
+    flush();
+    batches_flushed = batch_count;
+    batch_count = 0;
     SDL_RenderPresent(m.r);
+    render_stats().end_frame();
+}
+
+inline const RenderStats &Graphics::stats()
+{
+    return render_stats();
+}
+
+inline bool Graphics::batching()
+{
+    return batch_flag;
+}
+
+/// Primitives are drawn immediately, so any queued quads must go out first to
+/// preserve the drawing order.
+/// Quads batched before deferral started go first; replay() may batch more.
+inline void Graphics::flush()
+{
+    if (!batch_indices.empty())
+        flush_batch();
+    if (!commands.empty())
+        replay();
+    if (!batch_indices.empty())
+        flush_batch();
+}
+
+inline bool Graphics::deferring()
+{
+    return defer_flag;
+}
+
+inline void Graphics::set_layer(int z)
+{
+    layer = z;
+}
+
+inline int Graphics::get_layer()
+{
+    return layer;
+}
+
+inline const Point *Graphics::shift_all(const Point *k, int count)
+{
+    if (!origin.x && !origin.y)
+        return k;
+
+    scratch_points.resize(count);
+    for (int i = 0; i < count; i++)
+        scratch_points[i] = (Point) { k[i].x - origin.x, k[i].y - origin.y };
+    return scratch_points.data();
+}
+
+inline const Rect *Graphics::shift_all(const Rect *k, int count)
+{
+    if (!origin.x && !origin.y)
+        return k;
+
+    scratch_rects.resize(count);
+    for (int i = 0; i < count; i++)
+        scratch_rects[i] = shift(k[i]);
+    return scratch_rects.data();
 }
 
 inline int Graphics::point(int x, int y)
 {
-    return SDL_RenderDrawPoint(m.r, x, y);
+    if (defer_flag)
+        return record(DrawCommand::CMD_POINT, (Rect) {x, y, 1, 1});
+    flush();
+    render_stats().primitive();
+    return SDL_RenderDrawPoint(m.r, x - origin.x, y - origin.y);
 }
 
+/// Recorded points of one colour are replayed as a single call.
 inline int Graphics::points(const Point *points, int count)
 {
-    return SDL_RenderDrawPoints(m.r, points, count);
+    if (defer_flag) {
+        commands.reserve(commands.size() + count);
+        for (int i = 0; i < count; i++)
+            record(DrawCommand::CMD_POINT, (Rect) {points[i].x, points[i].y, 1, 1});
+        return 0;
+    }
+    flush();
+    render_stats().primitive();
+    return SDL_RenderDrawPoints(m.r, shift_all(points, count), count);
 }
 
 inline int Graphics::points(const std::vector<Point> &points)
 {
-    return SDL_RenderDrawLines(m.r, points.data(), points.size());
+    return this->points(points.data(), points.size());
 }
 
-inline int Graphics::line(int x1, int x2, int y1, int y2)
+inline int Graphics::line(int x1, int y1, int x2, int y2)
 {
-    return SDL_RenderDrawLine(m.r, x1, x1, y1, y2);
+    if (defer_flag)
+        return record(DrawCommand::CMD_LINE, (Rect) {x1, y1, x2, y2});
+    flush();
+    render_stats().primitive();
+    return SDL_RenderDrawLine(m.r, x1 - origin.x, y1 - origin.y,
+                                   x2 - origin.x, y2 - origin.y);
 }
 
 inline int Graphics::line(Rect k)
 {
-    return SDL_RenderDrawLine(m.r, k.x, k.y, k.x + k.w, k.y + k.h);
+    return line(k.x, k.y, k.x + k.w, k.y + k.h);
 }
 
 inline int Graphics::lines(const Point *points, int count)
 {
-    return SDL_RenderDrawLines(m.r, points, count);
+    if (defer_flag) {
+        commands.reserve(commands.size() + count);
+        for (int i = 1; i < count; i++)
+            record(DrawCommand::CMD_LINE, (Rect) {points[i - 1].x, points[i - 1].y,
+                                                  points[i].x, points[i].y});
+        return 0;
+    }
+    flush();
+    render_stats().primitive();
+    return SDL_RenderDrawLines(m.r, shift_all(points, count), count);
 }
 
 inline int Graphics::lines(const std::vector<Point> &points)
 {
-    return SDL_RenderDrawLines(m.r, points.data(), points.size());
+    return lines(points.data(), points.size());
 }
 
 inline int Graphics::rect(const Rect &rect)
 {
-    return SDL_RenderDrawRect(m.r, &rect);
+    if (defer_flag)
+        return record(DrawCommand::CMD_RECT, rect);
+    flush();
+    render_stats().primitive();
+    Rect k = shift(rect);
+    return SDL_RenderDrawRect(m.r, &k);
 }
 
+/// Recorded rects of one colour are replayed as a single call.
 inline int Graphics::rects(const Rect *rects, int count)
 {
-    return SDL_RenderDrawRects(m.r, rects, count);
+    if (defer_flag) {
+        commands.reserve(commands.size() + count);
+        for (int i = 0; i < count; i++)
+            record(DrawCommand::CMD_RECT, rects[i]);
+        return 0;
+    }
+    flush();
+    render_stats().primitive();
+    return SDL_RenderDrawRects(m.r, shift_all(rects, count), count);
 }
 
 inline int Graphics::rects(const std::vector<Rect> &rects)
 {
-    return SDL_RenderDrawRects(m.r, rects.data(), rects.size());
+    return this->rects(rects.data(), rects.size());
 }
 
 inline int Graphics::frect(const Rect &rect)
 {
-    return SDL_RenderFillRect(m.r, &rect);
+    if (defer_flag)
+        return record(DrawCommand::CMD_FILL, rect);
+    flush();
+    render_stats().primitive();
+    Rect k = shift(rect);
+    return SDL_RenderFillRect(m.r, &k);
 }
 
 inline int Graphics::frects(const Rect *rects, int count)
 {
-    return SDL_RenderFillRects(m.r, rects, count);
+    if (defer_flag) {
+        commands.reserve(commands.size() + count);
+        for (int i = 0; i < count; i++)
+            record(DrawCommand::CMD_FILL, rects[i]);
+        return 0;
+    }
+    flush();
+    render_stats().primitive();
+    return SDL_RenderFillRects(m.r, shift_all(rects, count), count);
 }
 
 inline int Graphics::frects(const std::vector<Rect> &rects)
 {
-    return SDL_RenderFillRects(m.r, rects.data(), rects.size());
+    return this->frects(rects.data(), rects.size());
 }
 
 };
@@ -0,0 +1,220 @@
+#include "media.hpp"
+
+namespace media {
+
+/*
+ * =============================================================================
+ * Request
+ * =============================================================================
+ */
+
+Loader::Request::~Request()
+{
+    SDL_FreeSurface(surface);
+    Mix_FreeChunk(sound);
+    Mix_FreeMusic(music);
+}
+
+/*
+ * =============================================================================
+ * Loader
+ * =============================================================================
+ */
+
+Loader::Loader(State &m, int threads): m(m)
+{
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(&Loader::work, this);
+}
+
+Loader::~Loader()
+{
+    {
+        std::lock_guard<std::mutex> l(lock);
+        quit = true;
+    }
+    wake.notify_all();
+
+    for (auto &i: workers)
+        i.join();
+}
+
+void Loader::work()
+{
+    for (;;) {
+        Handle k;
+
+        {
+            std::unique_lock<std::mutex> l(lock);
+            wake.wait(l, [this] { return quit || !queue.empty(); });
+            if (quit)
+                return;
+            k = queue.front();
+            queue.pop_front();
+        }
+
+        PROFILE_ZONE("Loader::load");
+        bool loaded = false;
+
+        switch (k->kind) {
+        case ASSET_IMAGE:
+            k->surface = IMG_Load(k->path.c_str());
+            loaded = k->surface != nullptr;
+            break;
+
+        case ASSET_SOUND:
+            k->sound = Mix_LoadWAV(k->path.c_str());
+            loaded = k->sound != nullptr;
+            break;
+
+        case ASSET_MUSIC:
+            k->music = Mix_LoadMUS(k->path.c_str());
+            loaded = k->music != nullptr;
+            break;
+        }
+
+        if (!loaded) {
+            printf("Asset not loaded: %s\n", k->path.c_str());
+            k->status = LOAD_FAILED;
+            continue;
+        }
+
+        // The registry is only used from the main thread.
+        std::lock_guard<std::mutex> l(lock);
+        k->status = LOAD_DECODED;
+        decoded.push_back(k);
+    }
+}
+
+static Assets::Kind asset_kind(Loader::Kind kind)
+{
+    switch (kind) {
+    case Loader::ASSET_SOUND:
+        return Assets::ASSET_SOUND;
+    case Loader::ASSET_MUSIC:
+        return Assets::ASSET_MUSIC;
+    default:
+        return Assets::ASSET_TEXTURE;
+    }
+}
+
+Loader::Handle Loader::request(Kind kind, std::string path)
+{
+    Handle k = std::make_shared<Request>(kind, path);
+
+    k->asset = m.assets.cached(asset_kind(kind), path);
+    if (k->asset) {
+        k->status = LOAD_READY;
+        return k;
+    }
+
+    {
+        std::lock_guard<std::mutex> l(lock);
+        queue.push_back(k);
+    }
+    wake.notify_one();
+
+    return k;
+}
+
+Loader::Handle Loader::image(std::string path)
+{
+    return request(ASSET_IMAGE, path);
+}
+
+Loader::Handle Loader::sound(std::string path)
+{
+    return request(ASSET_SOUND, path);
+}
+
+Loader::Handle Loader::music(std::string path)
+{
+    return request(ASSET_MUSIC, path);
+}
+
+void Loader::upload(int budget_us)
+{
+    uint64_t freq  = SDL_GetPerformanceFrequency();
+    uint64_t start = SDL_GetPerformanceCounter();
+    uint64_t budget = freq * budget_us / 1000000;
+
+    do {
+        Handle k;
+
+        {
+            std::lock_guard<std::mutex> l(lock);
+            if (decoded.empty())
+                return;
+            k = decoded.front();
+            decoded.pop_front();
+        }
+
+        PROFILE_ZONE("Loader::upload");
+
+        switch (k->kind) {
+        case ASSET_IMAGE: {
+            Texture *tx = create_texture(m.r, k->surface);
+            if (tx) {
+                Size size = { k->surface->w, k->surface->h };
+                k->asset = m.assets.add_texture(k->path, tx, size);
+            }
+            SDL_FreeSurface(k->surface);
+            k->surface = nullptr;
+            break;
+        }
+
+        case ASSET_SOUND:
+            k->asset = m.assets.add_sound(k->path, k->sound);
+            k->sound = nullptr;
+            break;
+
+        case ASSET_MUSIC:
+            k->asset = m.assets.add_music(k->path, k->music);
+            k->music = nullptr;
+            break;
+        }
+
+        if (k->asset) {
+            k->status = LOAD_READY;
+        } else {
+            printf("Asset not uploaded: %s\n", k->path.c_str());
+            k->status = LOAD_FAILED;
+        }
+    } while (SDL_GetPerformanceCounter() - start < budget);
+}
+
+size_t Loader::pending()
+{
+    std::lock_guard<std::mutex> l(lock);
+    return queue.size() + decoded.size();
+}
+
+Assets::Ref Loader::adopt(ObjectRef k, Handle h)
+{
+    if (!ready(h) || h->kind != ASSET_IMAGE)
+        return nullptr;
+
+    k.set_shared(h->asset->texture);
+    k.set_rect((Rect) {0, 0, h->asset->size.w, h->asset->size.h});
+    return h->asset;
+}
+
+Assets::Ref Loader::adopt(Sound &k, Handle h)
+{
+    if (!ready(h) || h->kind != ASSET_SOUND)
+        return nullptr;
+
+    k.set_shared(h->asset->sound);
+    return h->asset;
+}
+
+Assets::Ref Loader::adopt(Music &k, Handle h)
+{
+    if (!ready(h) || h->kind != ASSET_MUSIC)
+        return nullptr;
+
+    k.set_shared(h->asset->music);
+    return h->asset;
+}
+
+};
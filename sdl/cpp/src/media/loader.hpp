@@ -0,0 +1,114 @@
+#ifndef MEDIA_LOADER_H
+#define MEDIA_LOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common.hpp"
+#include "object.hpp"
+#include "audio.hpp"
+#include "assets.hpp"
+
+namespace media {
+
+/**
+ * Asynchronous asset loader.
+ *
+ * Worker threads decode images into surfaces and load sound and music data.
+ * Textures can only be created on the main thread, so finished loads wait
+ * until upload() is called; it spends at most a given time budget per call,
+ * creating textures and handing everything over to State::assets. Loads are
+ * thus shared with, and counted against the budget of, the asset registry,
+ * and requesting something already cached there finishes immediately.
+ *
+ * Each request returns a handle which can be polled with ready() and adopted
+ * by an Object, Sound or Music once done.
+ *
+ * @note Fonts are not loaded here: SDL_ttf shares a single FreeType library
+ *       between all fonts, which is not safe to use from several threads.
+ */
+
+class Loader {
+    public:
+        enum Kind {
+            ASSET_IMAGE,
+            ASSET_SOUND,
+            ASSET_MUSIC
+        };
+
+        enum Status {
+            LOAD_PENDING,
+            LOAD_DECODED, /// Waiting for upload()
+            LOAD_READY,
+            LOAD_FAILED
+        };
+
+        struct Request {
+            Kind kind;
+            std::string path;
+            std::atomic<int> status;
+            Surface *surface   = nullptr; /// Decoded, until upload()
+            SoundData *sound   = nullptr; /// Loaded, until upload()
+            MusicData *music   = nullptr; /// Loaded, until upload()
+            Assets::Ref asset;            /// Set once ready
+
+            Request(Kind kind, std::string path):
+                kind(kind), path(path), status(LOAD_PENDING) {}
+            ~Request();
+        };
+
+        typedef std::shared_ptr<Request> Handle;
+
+    protected:
+        State &m;
+        std::vector<std::thread> workers;
+        std::deque<Handle> queue;   /// Waiting for a worker
+        std::deque<Handle> decoded; /// Waiting for upload()
+        std::mutex lock;
+        std::condition_variable wake;
+        bool quit = false;
+
+        void work();
+        Handle request(Kind kind, std::string path);
+
+    public:
+        Loader(State &m, int threads = 2);
+        ~Loader();
+
+        Handle image(std::string path);
+        Handle sound(std::string path);
+        Handle music(std::string path);
+
+        /// Creates textures for decoded images and registers finished loads
+        /// with the asset registry. Called once per frame from the main
+        /// thread. At least one load is handed over per call.
+        void upload(int budget_us = 2000);
+
+        /// Requests not yet ready.
+        size_t pending();
+
+        /// Points the owner at a finished asset. The returned handle must be
+        /// kept for as long as the owner is used.
+        /// @return null if the asset isn't ready yet or failed to load.
+        Assets::Ref adopt(ObjectRef k, Handle h);
+        Assets::Ref adopt(Sound &k, Handle h);
+        Assets::Ref adopt(Music &k, Handle h);
+
+        inline bool ready(const Handle &h)
+        {
+            return h->status == LOAD_READY;
+        }
+
+        inline bool failed(const Handle &h)
+        {
+            return h->status == LOAD_FAILED;
+        }
+};
+
+};
+
+#endif
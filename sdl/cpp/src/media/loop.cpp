@@ -0,0 +1,56 @@
+#include "media.hpp"
+
+namespace media {
+
+Loop::Loop(State &m, int step_hz, Pacing pacing): m(m)
+{
+    freq = SDL_GetPerformanceFrequency();
+    step_ticks = freq / step_hz;
+    frame_ticks = m.max_fps > 0 ? freq / m.max_fps : 0;
+    frame_start = SDL_GetPerformanceCounter();
+    set_pacing(pacing);
+}
+
+void Loop::set_pacing(Pacing pacing)
+{
+    this->pacing = pacing;
+    SDL_RenderSetVSync(m.r, pacing == PACING_VSYNC);
+}
+
+void Loop::end()
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+
+    m.fps.end = now;
+    m.fps.elapsed = now - frame_start;
+
+    if (pacing == PACING_VSYNC || pacing == PACING_FIXED || frame_ticks == 0)
+        return;
+
+    uint64_t deadline = frame_start + frame_ticks;
+    if (now >= deadline)
+        return;
+
+    uint64_t remaining = deadline - now;
+
+    switch (pacing) {
+    case PACING_SLEEP:
+        SDL_Delay(remaining * 1000 / freq);
+        break;
+
+    case PACING_BUSY_WAIT: {
+        // SDL_Delay is only good to a millisecond or two, so sleep short of
+        // the deadline and spin for the rest.
+        uint64_t margin = freq * SPIN_MARGIN_MS / 1000;
+        if (remaining > margin)
+            SDL_Delay((remaining - margin) * 1000 / freq);
+        while (SDL_GetPerformanceCounter() < deadline);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+};
@@ -0,0 +1,127 @@
+#ifndef MEDIA_LOOP_H
+#define MEDIA_LOOP_H
+
+#include "common.hpp"
+#include "state.hpp"
+
+namespace media {
+
+/**
+ * Fixed timestep frame loop driver.
+ *
+ * Time is measured with SDL_GetPerformanceCounter. Real frame time is added
+ * to an accumulator, which step() drains in fixed increments; whatever is
+ * left over is published as State::alpha for interpolating the draw.
+ *
+ *     loop.start();
+ *     // events
+ *     while (loop.step())
+ *         scene->update();
+ *     // draw, present
+ *     loop.end();
+ */
+
+class Loop {
+    public:
+        enum Pacing {
+            PACING_VSYNC,    /// Let SDL_RenderPresent block on vsync
+            PACING_SLEEP,    /// SDL_Delay until the frame deadline
+            PACING_BUSY_WAIT, /// SDL_Delay most of the way, then spin
+            /// No pacing, and exactly one step per frame whatever the real
+            /// frame time. For headless throughput runs.
+            PACING_FIXED
+        };
+
+    protected:
+        /// Longest frame fed to the simulation, so a stall can't trigger a
+        /// long burst of catch-up steps.
+        static const int MAX_FRAME_MS = 250;
+        /// How much of the frame the busy wait spins for.
+        static const int SPIN_MARGIN_MS = 2;
+
+        State &m;
+        Pacing pacing;
+        uint64_t freq;
+        uint64_t step_ticks;
+        uint64_t frame_ticks;  /// Target frame length, 0 if uncapped
+        uint64_t frame_start;
+        uint64_t accumulator = 0;
+        uint64_t sim_ticks = 0;
+        uint64_t sim_ms = 0;
+        int steps = 0;   /// Steps run this frame
+        int forced = -1; /// Steps left to force this frame, -1 if not forced
+
+    public:
+        Loop(State &m, int step_hz = 60, Pacing pacing = PACING_VSYNC);
+
+        void set_pacing(Pacing pacing);
+
+        inline void start();   /// Called at start of frame
+        inline bool step();    /// True while a fixed update should run
+        void end();            /// Called after present, paces the frame
+
+        /// Makes this frame run exactly n steps, whatever the real time.
+        /// Call after start(); used to replay recorded input.
+        inline void force_steps(int n);
+        inline int frame_steps(); /// Steps run so far this frame
+};
+
+inline void Loop::start()
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+    uint64_t period = now - frame_start;
+
+    m.fps.begin(now);
+
+    if (period > freq * MAX_FRAME_MS / 1000)
+        period = freq * MAX_FRAME_MS / 1000;
+
+    if (pacing == PACING_FIXED)
+        accumulator = step_ticks;
+    else
+        accumulator += period;
+
+    frame_start = now;
+    steps = 0;
+}
+
+inline bool Loop::step()
+{
+    if (forced == 0) {
+        forced = -1;
+        m.alpha = 0;
+        return false;
+    } else if (forced > 0) {
+        forced--;
+    } else if (accumulator < step_ticks) {
+        m.alpha = accumulator / (float) step_ticks;
+        return false;
+    } else {
+        accumulator -= step_ticks;
+    }
+
+    steps++;
+    sim_ticks += step_ticks;
+
+    // Whole milliseconds of simulated time; the remainder carries over so
+    // Timers don't drift.
+    uint64_t now_ms = sim_ticks * 1000 / freq;
+    m.delta = now_ms - sim_ms;
+    sim_ms = now_ms;
+    return true;
+}
+
+inline void Loop::force_steps(int n)
+{
+    forced = n;
+    accumulator = 0;
+}
+
+inline int Loop::frame_steps()
+{
+    return steps;
+}
+
+};
+
+#endif
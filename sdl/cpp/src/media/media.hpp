@@ -2,11 +2,22 @@
 #define MEDIA_H
 
 #include "common.hpp"
+#include "profile.hpp"
+#include "stats.hpp"
 #include "audio.hpp"
 #include "text.hpp"
 #include "object.hpp"
+#include "atlas.hpp"
+#include "loader.hpp"
+#include "assets.hpp"
 #include "timer.hpp"
+#include "fps.hpp"
+#include "projectile.hpp"
+#include "spatial.hpp"
+#include "replay.hpp"
+#include "events.hpp"
 #include "state.hpp"
 #include "graphics.hpp"
+#include "overlay.hpp"
 
 #endif
@@ -1,4 +1,5 @@
 #include "object.hpp"
+#include "stats.hpp"
 
 namespace media {
 
@@ -13,10 +14,20 @@ void Object::set(SDL_Texture *texture) {
         this->free();
     }
     this->texture = texture;
+    this->shared = false;
+}
+
+void Object::set_shared(SDL_Texture *texture) {
+    if (this->texture != nullptr) {
+        this->free();
+    }
+    this->texture = texture;
+    this->shared = true;
 }
 
 void Object::free() {
-    SDL_DestroyTexture(this->texture);
+    if (!this->shared)
+        destroy_texture(this->texture);
 }
 
 /*
@@ -29,9 +40,30 @@ void ClipObject::set(SDL_Texture *texture) {
     if (this->texture != nullptr) {
         this->free();
     }
+
+    if (this->shared) {
+        // Drop the previous region's clipping.
+        this->origin = {0, 0};
+        this->src_rect_ptr = nullptr;
+    }
+
     this->texture = texture;
+    this->shared = false;
     SDL_QueryTexture(this->texture, nullptr, nullptr, &w, &h);
 }
 
+void ClipObject::set_region(SDL_Texture *texture, Rect region) {
+    if (this->texture != nullptr) {
+        this->free();
+    }
+    this->texture = texture;
+    this->shared = true;
+    this->origin = {region.x, region.y};
+    this->w = region.w;
+    this->h = region.h;
+    clip_src(region.w, region.h);
+    set_rect((Rect) {0, 0, region.w, region.h});
+}
+
 
 };
@@ -26,10 +26,17 @@ struct Object {
     Texture *texture;
     Rect dest_rect;
 
+    /// Set if the texture belongs to someone else (e.g. an Atlas page) and
+    /// must not be destroyed by this object.
+    bool shared = false;
+
     /// Explicitly used to reassign textures. Automatically frees an existing
     /// allocated texture if it exists.
     virtual void set(SDL_Texture *texture);
 
+    /// Points the object at a texture it does not own.
+    void set_shared(SDL_Texture *texture);
+
     /// Frees the texture,
     void free();
 
@@ -98,12 +105,19 @@ struct ClipObject : Object {
     Rect src_rect;
     Rect *src_rect_ptr = nullptr;
 
+    /// Position of the image inside its texture. Non-zero only for regions of
+    /// a shared texture; src_rect is always kept relative to the image.
+    Point origin = {0, 0};
+
     int w;
     int h;
 
     /// Overridden to store actual width and height as well.
     void set(SDL_Texture *texture);
 
+    /// Points the object at a sub-rectangle of a texture it does not own.
+    void set_region(SDL_Texture *texture, Rect region);
+
     /// Clips the src rect and the width and height of the dest rect.
     inline void clip(int w, int h);
     inline void clip(int w);
@@ -127,8 +141,8 @@ struct ClipObject : Object {
 inline void ClipObject::clip_src(int w, int h)
 {
     src_rect_ptr = &src_rect;
-    src_rect.x = 0;
-    src_rect.y = 0;
+    src_rect.x = origin.x;
+    src_rect.y = origin.y;
     src_rect.w = w;
     src_rect.h = h;
 }
@@ -136,8 +150,8 @@ inline void ClipObject::clip_src(int w, int h)
 inline void ClipObject::clip_src(int w)
 {
     src_rect_ptr = &src_rect;
-    src_rect.x = 0;
-    src_rect.y = 0;
+    src_rect.x = origin.x;
+    src_rect.y = origin.y;
     src_rect.w = w;
 }
 
@@ -146,6 +160,8 @@ inline void ClipObject::clip_src(Rect k)
 {
     src_rect_ptr = &src_rect;
     src_rect = k;
+    src_rect.x += origin.x;
+    src_rect.y += origin.y;
 }
 
 inline void ClipObject::clip(int w, int h)
@@ -178,15 +194,25 @@ inline void ClipObject::clip(Rect k)
 
 inline void ClipObject::clip_clear_src()
 {
-    src_rect_ptr = nullptr;
+    if (shared) {
+        // A region can never go unclipped, or it would show the whole page.
+        clip_src(w, h);
+    } else {
+        src_rect_ptr = nullptr;
+    }
 }
 
 inline void ClipObject::clip_clear()
 {
-    src_rect_ptr = nullptr;
-    Size k = tx_dims();
-    dest_rect.w = k.w;
-    dest_rect.h = k.h;
+    clip_clear_src();
+    if (shared) {
+        dest_rect.w = w;
+        dest_rect.h = h;
+    } else {
+        Size k = tx_dims();
+        dest_rect.w = k.w;
+        dest_rect.h = k.h;
+    }
 }
 
 /// Typedef used for function arguments to pass an Object.
@@ -0,0 +1,99 @@
+#include "media.hpp"
+
+namespace media {
+
+DebugOverlay::DebugOverlay(State &m, Graphics &g, Text &t, int width):
+    m(m), g(g), t(t), width(width)
+{
+    line_h = t.get_line_height();
+
+    Texture *tx = create_texture(m.r, SDL_PIXELFORMAT_ARGB8888,
+                                 SDL_TEXTUREACCESS_TARGET,
+                                 width, line_h * MAX_SLOTS);
+    SDL_SetTextureBlendMode(tx, SDL_BLENDMODE_BLEND);
+    target.set(tx);
+    target.set_rect((Rect) {0, 0, width, 0});
+}
+
+int DebugOverlay::add(const char *name)
+{
+    if (slot_count >= MAX_SLOTS)
+        return -1;
+
+    int slot = slot_count++;
+    slots[slot].name = name;
+    slots[slot].line[0] = '\0';
+    set_line(slot, "-");
+
+    // Only the rows in use are painted.
+    target.dest_rect.h = line_h * slot_count;
+    return slot;
+}
+
+void DebugOverlay::set_line(int slot, const char *value)
+{
+    char line[LINE_SIZE];
+
+    if (slot < 0 || slot >= slot_count)
+        return;
+
+    Slot &k = slots[slot];
+    snprintf(line, sizeof(line), "%s: %s", k.name, value);
+
+    if (strcmp(line, k.line) == 0)
+        return;
+
+    memcpy(k.line, line, sizeof(line));
+    k.dirty = true;
+    dirty = true;
+}
+
+void DebugOverlay::set(int slot, const char *value)
+{
+    set_line(slot, value);
+}
+
+void DebugOverlay::set_int(int slot, long long value)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lld", value);
+    set_line(slot, buf);
+}
+
+void DebugOverlay::set_float(int slot, double value, int precision)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", precision, value);
+    set_line(slot, buf);
+}
+
+void DebugOverlay::draw()
+{
+    if (!show_flag || slot_count == 0)
+        return;
+
+    if (dirty) {
+        g.set_paint_target(target);
+
+        for (int i = 0; i < slot_count; i++) {
+            if (!slots[i].dirty)
+                continue;
+
+            // The renderer's default blend mode is none, so this replaces the
+            // old row outright.
+            g.set_color(0, 0, 0, 160);
+            g.frect((Rect) {0, i * line_h, width, line_h});
+            t.draw(g, slots[i].line, (Point) {4, i * line_h});
+            slots[i].dirty = false;
+        }
+
+        g.reset_paint_target();
+        dirty = false;
+    }
+
+    target.dest_rect.x = pos.x;
+    target.dest_rect.y = pos.y;
+    g.paint(target, (Rect) {0, 0, target.dest_rect.w, target.dest_rect.h});
+}
+
+};
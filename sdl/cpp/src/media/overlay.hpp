@@ -0,0 +1,77 @@
+#ifndef MEDIA_OVERLAY_H
+#define MEDIA_OVERLAY_H
+
+#include "common.hpp"
+#include "object.hpp"
+
+namespace media {
+
+/**
+ * Debug HUD with a fixed number of metric slots.
+ *
+ * Each slot is one row of a cached render target. Setting a value formats it
+ * into the slot's own buffer, and only rows whose text changed are repainted.
+ * Nothing allocates after construction, and an unchanged overlay costs a
+ * single texture copy per frame.
+ */
+
+class DebugOverlay {
+    public:
+        static const int MAX_SLOTS = 16;
+        static const size_t LINE_SIZE = 64;
+
+    protected:
+        struct Slot {
+            const char *name;
+            char line[LINE_SIZE];
+            bool dirty;
+        };
+
+        State &m;
+        Graphics &g;
+        Text &t;
+        Object target;
+        Slot slots[MAX_SLOTS];
+        int slot_count = 0;
+        int width;
+        int line_h;
+        bool show_flag = true;
+        bool dirty = false;
+
+        void set_line(int slot, const char *line);
+
+    public:
+        Point pos = {0, 0};
+
+        DebugOverlay(State &m, Graphics &g, Text &t, int width = 320);
+
+        /// Registers a metric. The name must outlive the overlay.
+        /// @return Slot index, or -1 if all slots are taken.
+        int add(const char *name);
+
+        void set(int slot, const char *value);
+        void set_int(int slot, long long value);
+        void set_float(int slot, double value, int precision = 2);
+
+        /// Repaints changed slots and paints the overlay.
+        void draw();
+
+        inline bool shown()
+        {
+            return show_flag;
+        }
+
+        inline void show()
+        {
+            show_flag = true;
+        }
+
+        inline void hide()
+        {
+            show_flag = false;
+        }
+};
+
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "profile.hpp"
+
+namespace media {
+
+namespace {
+
+struct ThreadBuffer {
+    std::vector<ProfileEvent> events;
+    std::atomic<uint64_t> head; /// Events ever pushed
+    int tid;
+
+    ThreadBuffer(int tid): events(Profiler::BUFFER_EVENTS), head(0), tid(tid) {}
+};
+
+// Buffers live until exit, so events of finished threads can still be
+// written.
+std::mutex registry_lock;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+thread_local ThreadBuffer *local = nullptr;
+
+ThreadBuffer *register_thread()
+{
+    std::lock_guard<std::mutex> l(registry_lock);
+    registry.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer(registry.size() + 1)));
+    return registry.back().get();
+}
+
+};
+
+std::atomic<bool> Profiler::enabled_flag(false);
+
+void Profiler::enable(bool k)
+{
+    enabled_flag.store(k, std::memory_order_relaxed);
+}
+
+void Profiler::push(const char *name, uint64_t start, uint64_t end)
+{
+    if (!local)
+        local = register_thread();
+
+    uint64_t h = local->head.load(std::memory_order_relaxed);
+    local->events[h % BUFFER_EVENTS] = (ProfileEvent) { name, start, end };
+    local->head.store(h + 1, std::memory_order_release);
+}
+
+void Profiler::clear()
+{
+    std::lock_guard<std::mutex> l(registry_lock);
+
+    // Racy against threads still recording, like write().
+    for (auto &i: registry)
+        i->head.store(0, std::memory_order_relaxed);
+}
+
+/* ===== Trace export ===== */
+
+bool Profiler::write(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return false;
+
+    std::lock_guard<std::mutex> l(registry_lock);
+    const char *sep = "";
+
+    // Timestamps are made relative to the earliest event, in microseconds.
+    uint64_t base = UINT64_MAX;
+    for (auto &i: registry) {
+        uint64_t h = i->head.load(std::memory_order_acquire);
+        uint64_t first = h > BUFFER_EVENTS ? h - BUFFER_EVENTS : 0;
+        for (uint64_t j = first; j < h; j++) {
+            if (i->events[j % BUFFER_EVENTS].start < base)
+                base = i->events[j % BUFFER_EVENTS].start;
+        }
+    }
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+
+    for (auto &i: registry) {
+        uint64_t h = i->head.load(std::memory_order_acquire);
+        uint64_t first = h > BUFFER_EVENTS ? h - BUFFER_EVENTS : 0;
+
+        for (uint64_t j = first; j < h; j++) {
+            const ProfileEvent &k = i->events[j % BUFFER_EVENTS];
+            double ts = (k.start - base) / 1000.0;
+
+            if (k.end == k.start) {
+                fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\","
+                        "\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                        sep, k.name, ts, i->tid);
+            } else {
+                fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+                        "\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                        sep, k.name, ts, (k.end - k.start) / 1000.0, i->tid);
+            }
+            sep = ",";
+        }
+    }
+
+    fputs("\n]}\n", f);
+    fclose(f);
+    return true;
+}
+
+};
@@ -0,0 +1,104 @@
+#ifndef MEDIA_PROFILE_H
+#define MEDIA_PROFILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+
+namespace media {
+
+/**
+ * Scoped CPU profiler.
+ *
+ * Zones are timed in nanoseconds and kept in a ring buffer per thread, so
+ * recording takes no locks. The buffers can be written out at any time as
+ * Chrome trace JSON, for chrome://tracing or Perfetto.
+ *
+ *     void Foo::bar()
+ *     {
+ *         PROFILE_ZONE("Foo::bar");
+ *         ...
+ *     }
+ *
+ * Zone names must outlive the profiler; string literals are the intent.
+ * While disabled a zone costs one relaxed atomic load. Building without
+ * MEDIA_PROFILE removes the zones altogether.
+ *
+ * Entries a thread is overwriting while write() runs may come out garbled,
+ * so write from a quiet point such as between frames.
+ */
+
+struct ProfileEvent {
+    const char *name;
+    uint64_t start; /// ns
+    uint64_t end;   /// ns, equal to start for instant events
+};
+
+class Profiler {
+    public:
+        static const int BUFFER_EVENTS = 1 << 16; /// Per thread
+
+    protected:
+        static std::atomic<bool> enabled_flag;
+
+    public:
+        static inline bool enabled()
+        {
+            return enabled_flag.load(std::memory_order_relaxed);
+        }
+
+        static void enable(bool k);
+
+        static inline uint64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        static void push(const char *name, uint64_t start, uint64_t end);
+
+        /// Marks the start of a frame.
+        static inline void frame()
+        {
+            if (enabled()) {
+                uint64_t k = now();
+                push("frame", k, k);
+            }
+        }
+
+        /// Writes every thread's events. @return false if path can't be opened.
+        static bool write(const char *path);
+
+        /// Drops all recorded events.
+        static void clear();
+};
+
+class ProfileZone {
+    protected:
+        const char *name;
+        uint64_t start;
+
+    public:
+        inline ProfileZone(const char *name):
+            name(name), start(Profiler::enabled() ? Profiler::now() : 0) {}
+
+        inline ~ProfileZone()
+        {
+            if (start)
+                Profiler::push(name, start, Profiler::now());
+        }
+};
+
+};
+
+#ifdef MEDIA_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) media::ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FRAME() media::Profiler::frame()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FRAME()
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#include "media.hpp"
+
+namespace media {
+
+ProjectilePool::ProjectilePool(int capacity, Size dims):
+    cap(capacity), dims(dims), bounds((Rect) {0, 0, 0, 0}),
+    x(capacity), y(capacity), vx(capacity), vy(capacity), ttl(capacity)
+{
+    rects.reserve(capacity);
+}
+
+/* ===== Update ===== */
+
+void ProjectilePool::update(float dt)
+{
+    int n = live;
+    float *px = x.data(), *py = y.data();
+    float *pvx = vx.data(), *pvy = vy.data();
+    float *pttl = ttl.data();
+
+    // Integration. Kept free of branches so it vectorises.
+    for (int i = 0; i < n; i++) {
+        px[i]   += pvx[i] * dt;
+        py[i]   += pvy[i] * dt;
+        pttl[i] -= dt;
+    }
+
+    // Compaction. Walk backwards so a moved-in projectile has already been
+    // checked.
+    float x1 = bounds.x - dims.w, x2 = bounds.x + bounds.w;
+    float y1 = bounds.y - dims.h, y2 = bounds.y + bounds.h;
+
+    for (int i = n - 1; i >= 0; i--) {
+        bool dead = pttl[i] <= 0;
+
+        if (bounds_flag)
+            dead = dead || px[i] < x1 || px[i] > x2 || py[i] < y1 || py[i] > y2;
+
+        if (dead)
+            remove(i);
+    }
+}
+
+/* ===== Drawing ===== */
+
+void ProjectilePool::draw(Graphics &g)
+{
+    rects.resize(live);
+
+    for (int i = 0; i < live; i++)
+        rects[i] = (Rect) { (int) x[i], (int) y[i], dims.w, dims.h };
+
+    if (live > 0)
+        g.frects(rects);
+}
+
+};
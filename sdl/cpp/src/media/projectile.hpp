@@ -0,0 +1,117 @@
+#ifndef MEDIA_PROJECTILE_H
+#define MEDIA_PROJECTILE_H
+
+#include <vector>
+
+#include "common.hpp"
+
+namespace media {
+
+/**
+ * Fixed capacity pool of identical projectiles.
+ *
+ * State is kept as a structure of arrays so that update() is a straight loop
+ * over contiguous floats which the compiler can vectorise. Dead projectiles
+ * are removed by moving the last live one into their slot, so live
+ * projectiles are always the first count() entries and their order is not
+ * stable.
+ *
+ * Velocities are in pixels per step and lifetimes in steps, where a step is
+ * whatever unit is passed to update(); usually one fixed update.
+ */
+
+class ProjectilePool {
+    protected:
+        int cap;
+        int live = 0;
+        Size dims;            /// Size of every projectile
+        Rect bounds;          /// Projectiles leaving this are culled
+        bool bounds_flag = false;
+
+        std::vector<float> x, y, vx, vy, ttl;
+        std::vector<Rect> rects; /// Scratch for draw()
+
+        inline void remove(int i);
+
+    public:
+        ProjectilePool(int capacity, Size dims);
+
+        /// @return false if the pool is full.
+        inline bool spawn(float x, float y, float vx, float vy, float ttl);
+
+        /// Advances every projectile by dt steps and removes dead ones.
+        void update(float dt = 1.0f);
+
+        /// Submits all projectiles as a single frects() batch.
+        void draw(Graphics &g);
+
+        inline void kill(int i);
+        inline void clear();
+        inline void set_bounds(Rect k);
+
+        inline int count();
+        inline int capacity();
+        inline Rect rect(int i); /// Bounding box of live projectile i
+};
+
+inline void ProjectilePool::remove(int i)
+{
+    int j = --live;
+
+    x[i]   = x[j];
+    y[i]   = y[j];
+    vx[i]  = vx[j];
+    vy[i]  = vy[j];
+    ttl[i] = ttl[j];
+}
+
+inline bool ProjectilePool::spawn(float x, float y, float vx, float vy, float ttl)
+{
+    if (live == cap)
+        return false;
+
+    this->x[live]   = x;
+    this->y[live]   = y;
+    this->vx[live]  = vx;
+    this->vy[live]  = vy;
+    this->ttl[live] = ttl;
+    live++;
+    return true;
+}
+
+/// Removes projectile i. The last projectile takes its index.
+inline void ProjectilePool::kill(int i)
+{
+    if (i >= 0 && i < live)
+        remove(i);
+}
+
+inline void ProjectilePool::clear()
+{
+    live = 0;
+}
+
+inline void ProjectilePool::set_bounds(Rect k)
+{
+    bounds = k;
+    bounds_flag = true;
+}
+
+inline int ProjectilePool::count()
+{
+    return live;
+}
+
+inline int ProjectilePool::capacity()
+{
+    return cap;
+}
+
+inline Rect ProjectilePool::rect(int i)
+{
+    return (Rect) { (int) x[i], (int) y[i], dims.w, dims.h };
+}
+
+};
+
+#endif
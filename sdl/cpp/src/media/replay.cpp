@@ -0,0 +1,192 @@
+#include <cstring>
+
+#include "media.hpp"
+
+namespace media {
+
+InputReplay::~InputReplay()
+{
+    if (f)
+        fclose(f);
+}
+
+void InputReplay::fail(const char *what)
+{
+    fprintf(stderr, "[REPLAY] %s\n", what);
+    if (f)
+        fclose(f);
+    f = nullptr;
+    mode = MODE_OFF;
+}
+
+/// Bytes of the event that its type uses.
+size_t InputReplay::event_size(const SDL_Event &e)
+{
+    switch (e.type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        return sizeof(SDL_KeyboardEvent);
+
+    case SDL_MOUSEMOTION:
+        return sizeof(SDL_MouseMotionEvent);
+
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        return sizeof(SDL_MouseButtonEvent);
+
+    case SDL_MOUSEWHEEL:
+        return sizeof(SDL_MouseWheelEvent);
+
+    case SDL_WINDOWEVENT:
+        return sizeof(SDL_WindowEvent);
+
+    case SDL_TEXTINPUT:
+        return sizeof(SDL_TextInputEvent);
+
+    case SDL_TEXTEDITING:
+        return sizeof(SDL_TextEditingEvent);
+
+    case SDL_QUIT:
+        return sizeof(SDL_QuitEvent);
+
+    case SDL_DROPFILE:
+    case SDL_DROPTEXT:
+    case SDL_USEREVENT:
+        return 0;
+
+    default:
+        return sizeof(SDL_Event);
+    }
+}
+
+/* ===== Recording ===== */
+
+bool InputReplay::record(const char *path, uint32_t seed)
+{
+    if (!(f = fopen(path, "wb"))) {
+        fail("Can't open recording for writing");
+        return false;
+    }
+
+    uint32_t version = VERSION;
+
+    fwrite("MREC", 1, 4, f);
+    fwrite(&version, sizeof(version), 1, f);
+    fwrite(&seed, sizeof(seed), 1, f);
+
+    seed_value = seed;
+    mode = MODE_RECORD;
+    return true;
+}
+
+void InputReplay::end_frame(int steps)
+{
+    if (mode == MODE_PLAY) {
+        frame_done = false;
+        return;
+    }
+
+    if (mode != MODE_RECORD)
+        return;
+
+    uint8_t tag = TAG_FRAME;
+    uint16_t k = steps;
+
+    fwrite(&tag, 1, 1, f);
+    fwrite(&k, sizeof(k), 1, f);
+}
+
+/* ===== Playback ===== */
+
+bool InputReplay::play(const char *path)
+{
+    char magic[4];
+    uint32_t version;
+
+    if (!(f = fopen(path, "rb"))) {
+        fail("Can't open recording");
+        return false;
+    }
+
+    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, "MREC", 4) != 0 ||
+        fread(&version, sizeof(version), 1, f) != 1 || version != VERSION ||
+        fread(&seed_value, sizeof(seed_value), 1, f) != 1) {
+        fail("Not a recording, or of another version");
+        return false;
+    }
+
+    mode = MODE_PLAY;
+    return true;
+}
+
+/**
+ * Reads records up to the next event.
+ * @return false at the end of the frame or of the file.
+ */
+bool InputReplay::read_record(SDL_Event *e)
+{
+    uint8_t tag;
+    uint16_t k;
+
+    if (fread(&tag, 1, 1, f) != 1 || fread(&k, sizeof(k), 1, f) != 1) {
+        done_flag = true;
+        steps = 0;
+        return false;
+    }
+
+    if (tag == TAG_FRAME) {
+        steps = k;
+        frame_done = true;
+        return false;
+    }
+
+    if (tag != TAG_EVENT || k > sizeof(SDL_Event) ||
+        fread(e, 1, k, f) != k) {
+        fail("Corrupt recording");
+        done_flag = true;
+        steps = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool InputReplay::poll(SDL_Event *e)
+{
+    switch (mode) {
+    case MODE_OFF:
+        return SDL_PollEvent(e);
+
+    case MODE_RECORD: {
+        if (!SDL_PollEvent(e))
+            return false;
+
+        uint8_t tag = TAG_EVENT;
+        uint16_t k = event_size(*e);
+
+        if (k > 0) {
+            fwrite(&tag, 1, 1, f);
+            fwrite(&k, sizeof(k), 1, f);
+            fwrite(e, 1, k, f);
+        }
+        return true;
+    }
+
+    case MODE_PLAY:
+        // Real input is dropped, but the window can still be closed.
+        while (SDL_PollEvent(e)) {
+            if (e->type == SDL_QUIT)
+                return true;
+        }
+
+        if (frame_done || done_flag)
+            return false;
+
+        memset(e, 0, sizeof(*e));
+        return read_record(e);
+    }
+
+    return false;
+}
+
+};
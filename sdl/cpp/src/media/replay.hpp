@@ -0,0 +1,109 @@
+#ifndef MEDIA_REPLAY_H
+#define MEDIA_REPLAY_H
+
+#include <cstdio>
+#include <cstdint>
+
+#include "common.hpp"
+
+namespace media {
+
+/**
+ * Records the input of a run to a file and plays it back.
+ *
+ * Stands in for SDL_PollEvent. While recording, polled events are written
+ * out along with the number of fixed steps each frame ran, so that playback
+ * reproduces the simulation exactly regardless of how fast it runs. The RNG
+ * seed is stored in the header.
+ *
+ * File layout, in native byte order:
+ *
+ *     header: "MREC", uint32 version, uint32 seed
+ *     frames: { TAG_EVENT, uint16 size, event bytes }*, TAG_FRAME, uint16 steps
+ *
+ * Only the part of SDL_Event used by its type is stored. Events carrying
+ * pointers (drops, user events) aren't recorded.
+ */
+
+class InputReplay {
+    public:
+        enum Mode {
+            MODE_OFF,    /// Plain SDL_PollEvent
+            MODE_RECORD,
+            MODE_PLAY
+        };
+
+    protected:
+        enum Tag {
+            TAG_EVENT = 1,
+            TAG_FRAME = 2
+        };
+
+        static const uint32_t VERSION = 1;
+
+        Mode mode = MODE_OFF;
+        FILE *f = nullptr;
+        uint32_t seed_value = 0;
+        int steps = 0;         /// Steps of the frame being played
+        bool frame_done = false;
+        bool done_flag = false;
+
+        static size_t event_size(const SDL_Event &e);
+        bool read_record(SDL_Event *e);
+        void fail(const char *what);
+
+    public:
+        InputReplay() {}
+        ~InputReplay();
+
+        /// Starts writing to path. @return false if the file can't be opened.
+        bool record(const char *path, uint32_t seed);
+
+        /// Starts reading from path. @return false on a missing or bad file.
+        bool play(const char *path);
+
+        /**
+         * Next event of the current frame, like SDL_PollEvent. When playing,
+         * real events are discarded except SDL_QUIT.
+         */
+        bool poll(SDL_Event *e);
+
+        /// Ends the frame. Records the steps run when recording.
+        void end_frame(int steps);
+
+        /// Steps the current frame ran when recorded. Valid once poll()
+        /// returned false.
+        inline int frame_steps();
+
+        /// Seed of the recording being played or written.
+        inline uint32_t seed();
+
+        /// True when playback has reached the end of the file.
+        inline bool done();
+
+        inline Mode get_mode();
+};
+
+inline int InputReplay::frame_steps()
+{
+    return steps;
+}
+
+inline uint32_t InputReplay::seed()
+{
+    return seed_value;
+}
+
+inline bool InputReplay::done()
+{
+    return done_flag;
+}
+
+inline InputReplay::Mode InputReplay::get_mode()
+{
+    return mode;
+}
+
+};
+
+#endif
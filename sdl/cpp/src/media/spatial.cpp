@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "media.hpp"
+
+namespace media {
+
+SpatialHash::SpatialHash(int cell_size, int table_bits):
+    cell(cell_size), mask((1u << table_bits) - 1),
+    starts((1u << table_bits) + 1) {}
+
+/* ===== Building ===== */
+
+void SpatialHash::build()
+{
+    int n = items.size();
+
+    std::fill(starts.begin(), starts.end(), 0);
+
+    // Count the entries of each bucket, shifted by one so the prefix sum
+    // below yields start offsets.
+    uint32_t total = 0;
+    for (int i = 0; i < n; i++) {
+        const Rect &k = items[i].rect;
+        int x1 = cell_of(k.x), x2 = cell_of(k.x + k.w - 1);
+        int y1 = cell_of(k.y), y2 = cell_of(k.y + k.h - 1);
+
+        for (int cy = y1; cy <= y2; cy++) {
+            for (int cx = x1; cx <= x2; cx++)
+                starts[hash(cx, cy) + 1]++;
+        }
+        total += (x2 - x1 + 1) * (y2 - y1 + 1);
+    }
+
+    for (size_t b = 1; b < starts.size(); b++)
+        starts[b] += starts[b - 1];
+
+    entries.resize(total);
+
+    // Fill using the start offsets as cursors, then shift them back.
+    for (int i = 0; i < n; i++) {
+        const Rect &k = items[i].rect;
+        int x1 = cell_of(k.x), x2 = cell_of(k.x + k.w - 1);
+        int y1 = cell_of(k.y), y2 = cell_of(k.y + k.h - 1);
+
+        for (int cy = y1; cy <= y2; cy++) {
+            for (int cx = x1; cx <= x2; cx++)
+                entries[starts[hash(cx, cy)]++] = (Entry) { i, cx, cy };
+        }
+    }
+
+    for (size_t b = starts.size() - 1; b > 0; b--)
+        starts[b] = starts[b - 1];
+    starts[0] = 0;
+
+    if (stamps.size() < items.size())
+        stamps.resize(items.size(), stamp);
+}
+
+void SpatialHash::build(const Rect *rects, int count)
+{
+    items.resize(count);
+    for (int i = 0; i < count; i++)
+        items[i] = (Item) { i, rects[i] };
+    build();
+}
+
+void SpatialHash::build(const std::vector<Rect> &rects)
+{
+    build(rects.data(), rects.size());
+}
+
+/* ===== Queries ===== */
+
+void SpatialHash::query(const Rect &k, std::vector<int> &out)
+{
+    int x1 = cell_of(k.x), x2 = cell_of(k.x + k.w - 1);
+    int y1 = cell_of(k.y), y2 = cell_of(k.y + k.h - 1);
+
+    // Stamps keep an item spanning several cells from being reported twice.
+    if (++stamp == 0) {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        stamp = 1;
+    }
+
+    for (int cy = y1; cy <= y2; cy++) {
+        for (int cx = x1; cx <= x2; cx++) {
+            uint32_t b = hash(cx, cy);
+
+            for (uint32_t e = starts[b]; e < starts[b + 1]; e++) {
+                const Entry &j = entries[e];
+                if (j.cx != cx || j.cy != cy || stamps[j.item] == stamp)
+                    continue;
+
+                stamps[j.item] = stamp;
+                if (util::rects_overlap(k, items[j.item].rect))
+                    out.push_back(items[j.item].id);
+            }
+        }
+    }
+}
+
+/**
+ * Items are compared within each cell. A pair sharing several cells is only
+ * reported from the cell holding the top left corner of its intersection.
+ */
+void SpatialHash::pairs(std::vector<Pair> &out)
+{
+    for (size_t b = 0; b + 1 < starts.size(); b++) {
+        uint32_t end = starts[b + 1];
+
+        for (uint32_t e = starts[b]; e < end; e++) {
+            const Entry &p = entries[e];
+            const Rect &a = items[p.item].rect;
+
+            for (uint32_t f = e + 1; f < end; f++) {
+                const Entry &q = entries[f];
+                if (q.cx != p.cx || q.cy != p.cy)
+                    continue;
+
+                const Rect &c = items[q.item].rect;
+                if (!util::rects_overlap(a, c))
+                    continue;
+
+                int x = a.x > c.x ? a.x : c.x;
+                int y = a.y > c.y ? a.y : c.y;
+                if (cell_of(x) != p.cx || cell_of(y) != p.cy)
+                    continue;
+
+                int i = items[p.item].id, j = items[q.item].id;
+                out.push_back(i < j ? Pair(i, j) : Pair(j, i));
+            }
+        }
+    }
+}
+
+};
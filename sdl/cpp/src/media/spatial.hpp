@@ -0,0 +1,106 @@
+#ifndef MEDIA_SPATIAL_H
+#define MEDIA_SPATIAL_H
+
+#include <vector>
+#include <utility>
+
+#include "common.hpp"
+
+namespace media {
+
+/**
+ * Uniform grid broadphase over rectangles.
+ *
+ * Meant to be rebuilt every frame: insert() the rectangles, then build() sorts
+ * them into a hashed table of cells with a counting sort. Nothing allocates
+ * once the internal arrays have grown to fit.
+ *
+ * Items are identified by the id given to insert(). Rectangles overlap if they
+ * share any area; touching edges don't count.
+ */
+
+class SpatialHash {
+    public:
+        typedef std::pair<int, int> Pair;
+
+    protected:
+        struct Item {
+            int id;
+            Rect rect;
+        };
+
+        /// An item's presence in one cell. Cells are stored with their
+        /// entries since several of them may hash to the same bucket.
+        struct Entry {
+            int item;
+            int cx;
+            int cy;
+        };
+
+        int cell;
+        uint32_t mask;
+        std::vector<Item> items;
+        std::vector<Entry> entries;
+        std::vector<uint32_t> starts;   /// Bucket b is entries[starts[b], starts[b + 1])
+        std::vector<uint32_t> stamps;   /// Per item, last query that saw it
+        uint32_t stamp = 0;
+
+        inline int cell_of(int k);
+        inline uint32_t hash(int cx, int cy);
+
+    public:
+        /**
+         * @param cell_size Width and height of a cell. Around the size of the
+         *                  typical item works best.
+         * @param table_bits log2 of the number of buckets.
+         */
+        SpatialHash(int cell_size = 64, int table_bits = 12);
+
+        inline void clear();
+        inline void insert(int id, const Rect &k);
+
+        /// Sorts the inserted items into cells. Call before querying.
+        void build();
+
+        /// Clears, inserts rects[i] with id i and builds.
+        void build(const Rect *rects, int count);
+        void build(const std::vector<Rect> &rects);
+
+        /// Appends the ids of items overlapping k.
+        void query(const Rect &k, std::vector<int> &out);
+
+        /// Appends every overlapping pair of items once, as (smaller id, larger id).
+        void pairs(std::vector<Pair> &out);
+
+        inline int size();
+};
+
+inline int SpatialHash::cell_of(int k)
+{
+    // Rounds towards negative infinity.
+    return k >= 0 ? k / cell : -((-k + cell - 1) / cell);
+}
+
+inline uint32_t SpatialHash::hash(int cx, int cy)
+{
+    return ((uint32_t) cx * 73856093u ^ (uint32_t) cy * 19349663u) & mask;
+}
+
+inline void SpatialHash::clear()
+{
+    items.clear();
+}
+
+inline void SpatialHash::insert(int id, const Rect &k)
+{
+    items.push_back((Item) { id, k });
+}
+
+inline int SpatialHash::size()
+{
+    return items.size();
+}
+
+};
+
+#endif
@@ -1,3 +1,5 @@
+#include <ctime>
+
 #include "media.hpp"
 
 namespace media {
@@ -7,14 +9,22 @@ State::State(
     int h,
     int max_fps,
     const char *window_name,
-    const char *font_path
-)
+    const char *font_path,
+    uint32_t flags
+): flags(flags), assets(*this)
 {
     int ret;
     
-    this->max_fps = (1000 / max_fps);
+    this->max_fps = max_fps;
     this->main_w = w;
     this->main_h = h;
+    this->seed = time(nullptr);
+
+    // Don't overwrite, so that e.g. SDL_AUDIODRIVER=disk can be chosen.
+    if (headless()) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    }
 
     try {
         if ((ret = SDL_Init(SDL_INIT_VIDEO)) < 0) {
@@ -22,30 +32,10 @@ State::State(
             throw ret;
         }
 
-        this->w = SDL_CreateWindow(
-            window_name,
-            SDL_WINDOWPOS_UNDEFINED,
-            SDL_WINDOWPOS_UNDEFINED,
-            this->main_w,
-            this->main_h,
-            SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE
-        );
-
-        if (!this->w) {
-            this->sdl_err_msg = SDL_GetError();
-            throw -1;
-        }
-
-        this->r = SDL_CreateRenderer(
-            this->w,
-            -1,
-            SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC
-        );
-
-        if (!this->r) {
-            this->sdl_err_msg = SDL_GetError();
-            throw -1;
-        }
+        if (headless())
+            init_headless();
+        else
+            init_window(window_name);
 
         SDL_SetRenderDrawColor(this->r, 0x00, 0x00, 0x00, 0xFF);
 
@@ -54,13 +44,16 @@ State::State(
             throw ret;
         }
 
-        this->font = TTF_OpenFont(font_path, 14);
+        this->font_ref = assets.font(font_path, Text::DEFAULT_SIZE);
 
-        if (!this->font) {
+        if (!this->font_ref) {
             this->sdl_err_msg = TTF_GetError();
             throw -1;
         }
 
+        this->font = this->font_ref->font;
+        this->text.reset(new Text(*this, this->font_ref));
+
         if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
             this->sdl_err_msg = IMG_GetError();
             throw -1;
@@ -79,11 +72,69 @@ State::State(
     this->active = true;
 }
 
+void State::init_window(const char *window_name)
+{
+    this->w = SDL_CreateWindow(
+        window_name,
+        SDL_WINDOWPOS_UNDEFINED,
+        SDL_WINDOWPOS_UNDEFINED,
+        this->main_w,
+        this->main_h,
+        SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE
+    );
+
+    if (!this->w) {
+        this->sdl_err_msg = SDL_GetError();
+        throw -1;
+    }
+
+    this->r = SDL_CreateRenderer(
+        this->w,
+        -1,
+        SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC
+    );
+
+    if (!this->r) {
+        this->sdl_err_msg = SDL_GetError();
+        throw -1;
+    }
+}
+
+/// Renders into a surface the size of the would-be window.
+void State::init_headless()
+{
+    this->target = SDL_CreateRGBSurfaceWithFormat(
+        0,
+        this->main_w,
+        this->main_h,
+        32,
+        SDL_PIXELFORMAT_ARGB8888
+    );
+
+    if (!this->target) {
+        this->sdl_err_msg = SDL_GetError();
+        throw -1;
+    }
+
+    this->r = SDL_CreateSoftwareRenderer(this->target);
+
+    if (!this->r) {
+        this->sdl_err_msg = SDL_GetError();
+        throw -1;
+    }
+}
+
 State::~State()
 {
+    // Cached assets must go before the renderer and subsystems they use.
+    this->text.reset();
+    this->font_ref.reset();
+    this->assets.clear();
     SDL_DestroyRenderer(this->r);
-    SDL_DestroyWindow(this->w);
-    TTF_CloseFont(this->font);
+    if (this->w)
+        SDL_DestroyWindow(this->w);
+    if (this->target)
+        SDL_FreeSurface(this->target);
     Mix_CloseAudio();
     SDL_Quit();
 }
@@ -108,6 +159,8 @@ void State::print_err()
 void State::display_err()
 {
     print_err();
+    if (headless())
+        return;
     SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", sdl_err_msg, nullptr);
 }
 
@@ -6,14 +6,20 @@
 #include "text.hpp"
 #include "object.hpp"
 #include "timer.hpp"
+#include "fps.hpp"
+#include "assets.hpp"
+#include "events.hpp"
 
 namespace media {
 
-struct FPSCounter {
-    uint64_t start;
-    uint64_t end;
-    uint64_t elapsed;
-    float value;
+/// Flags for State construction.
+enum StateFlags {
+    /**
+     * No window, sound or vsync. Uses SDL's dummy video and audio drivers
+     * unless SDL_VIDEODRIVER/SDL_AUDIODRIVER say otherwise, and renders with
+     * the software renderer into State::target. Errors are only printed.
+     */
+    STATE_HEADLESS = 1 << 0
 };
 
 /// Driver class.
@@ -23,30 +29,38 @@ class State {
         static constexpr char err_msg[ERROR_MESSAGE_SIZE] = "";
         const char *sdl_err_msg; /// Error Message Pointer
         bool fail_flag = false;  /// Has initialisation failed?
+        uint32_t flags;          /// StateFlags
+        Assets::Ref font_ref;
+
+        void init_window(const char *window_name);
+        void init_headless();
 
     /// @todo handle error throws
     public:
-        SDL_Window *w;       /// Default Window
+        SDL_Window *w = nullptr; /// Default Window, null when headless
         SDL_Renderer *r;     /// Default Renderer
+        Surface *target = nullptr; /// Offscreen render target when headless
         SDL_Event e;         /// Events
+        EventBus events;     /// Subscriptions to polled events
         TTF_Font *font;      /// Default Font
+        std::unique_ptr<Text> text; /// Glyph cache of the default font
+        Assets assets;       /// Shared asset registry
         FPSCounter fps; /// FPS tracker
         bool active;         /// Is frame loop active?
-        int max_fps;         /// Maximum FPS of game
+        int max_fps;         /// Maximum FPS of game, 0 for uncapped
         int main_w;          /// Main window width
         int main_h;          /// Main window height
-        uint32_t delta;      /// Delta Time
-
-// #if GAME_DEBUG_BUILD
-        std::map<std::string, std::string> debug_keys;
-// #endif
+        uint32_t delta = 0;  /// Delta Time of the current update, in ms
+        float alpha = 0;     /// Interpolation factor between the last two updates
+        uint32_t seed;       /// Seed for the game's random numbers
 
         State(
             int w = 800,
             int h = 600,
             int max_fps = 60,
             const char *window_name = "MediaEngine",
-            const char *font_path = "assets/font.otb"
+            const char *font_path = "assets/font.otb",
+            uint32_t flags = 0
         );
         ~State();
 
@@ -55,37 +69,23 @@ class State {
         void print_err();
         void display_err();
 
-        inline void loop_start();
-        inline void loop_end();
         inline float get_fps();
+        inline bool headless();
 };
 
-inline void State::loop_start()
-{
-    this->fps.start = SDL_GetTicks();
-}
-
-inline void State::loop_end()
+inline float State::get_fps()
 {
-    this->fps.end = SDL_GetTicks();
-    this->fps.elapsed = this->fps.end - this->fps.start;
-
-    if (this->fps.elapsed < this->max_fps)
-        SDL_Delay(this->max_fps - this->fps.elapsed);
-
-
-    this->delta = (SDL_GetTicks() - this->fps.start);
-
-    this->fps.value = 1000 / (float) this->delta;
+    return this->fps.value;
 }
 
-inline float State::get_fps()
+inline bool State::headless()
 {
-    return this->fps.value;
+    return flags & STATE_HEADLESS;
 }
 
 };
 
 #include "graphics.hpp"
+#include "loop.hpp"
 
 #endif
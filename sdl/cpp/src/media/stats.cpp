@@ -0,0 +1,85 @@
+#include "stats.hpp"
+
+namespace media {
+
+RenderStats &render_stats()
+{
+    static RenderStats stats;
+    return stats;
+}
+
+uint64_t texture_bytes(Texture *tx)
+{
+    uint32_t format;
+    int w, h;
+
+    if (!tx || SDL_QueryTexture(tx, &format, nullptr, &w, &h) < 0)
+        return 0;
+
+    return (uint64_t) w * h * SDL_BYTESPERPIXEL(format);
+}
+
+static Texture *track(Texture *tx)
+{
+    RenderStats &s = render_stats();
+
+    if (!tx)
+        return tx;
+
+    s.current.created++;
+    s.live_textures++;
+    s.vram += texture_bytes(tx);
+    return tx;
+}
+
+Texture *create_texture(SDL_Renderer *r, uint32_t format, int access, int w, int h)
+{
+    return track(SDL_CreateTexture(r, format, access, w, h));
+}
+
+Texture *create_texture(SDL_Renderer *r, Surface *s)
+{
+    if (!s)
+        return nullptr;
+
+    Texture *tx = track(SDL_CreateTextureFromSurface(r, s));
+    if (tx)
+        render_stats().upload((uint64_t) s->pitch * s->h);
+    return tx;
+}
+
+int update_texture(Texture *tx, const Rect *rect, const void *pixels, int pitch)
+{
+    int h = 0;
+
+    if (rect)
+        h = rect->h;
+    else
+        SDL_QueryTexture(tx, nullptr, nullptr, nullptr, &h);
+
+    int ret = SDL_UpdateTexture(tx, rect, pixels, pitch);
+    if (ret == 0)
+        render_stats().upload((uint64_t) pitch * h);
+    return ret;
+}
+
+void destroy_texture(Texture *tx)
+{
+    RenderStats &s = render_stats();
+
+    if (!tx)
+        return;
+
+    s.current.destroyed++;
+    s.live_textures--;
+    s.vram -= texture_bytes(tx);
+
+    // The address may be handed out again; don't count its next use as a bind
+    // of the same texture.
+    if (s.bound == tx)
+        s.bound = nullptr;
+
+    SDL_DestroyTexture(tx);
+}
+
+};
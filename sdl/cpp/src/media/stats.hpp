@@ -0,0 +1,124 @@
+#ifndef MEDIA_STATS_H
+#define MEDIA_STATS_H
+
+#include <cstdint>
+#include <SDL2/SDL.h>
+
+#include "common.hpp"
+
+namespace media {
+
+/**
+ * Renderer statistics.
+ *
+ * Counts what is actually submitted to SDL: a paint merged into a batch is
+ * not a draw call, the RenderGeometry call that flushes it is. Counters are
+ * per frame and roll over when Graphics::present() runs; read `last` for the
+ * most recent complete frame.
+ *
+ * Textures are tracked process-wide, provided they are created and destroyed
+ * through the helpers below. VRAM is estimated as width * height * bytes per
+ * pixel of the texture format, which ignores driver padding and mipmaps.
+ *
+ * Rendering is single threaded, so none of this is synchronised.
+ */
+
+struct RenderStats {
+    struct Frame {
+        int copies;        /// SDL_RenderCopy calls
+        int primitives;    /// Point, line, rect, fill and clear calls
+        int geometry;      /// SDL_RenderGeometry calls
+        int binds;         /// Draw calls that sample a texture
+        int switches;      /// Binds of a different texture than the last one
+        int colors;        /// Draw colour changes
+        int targets;       /// Render target switches
+        int created;       /// Textures created
+        int destroyed;     /// Textures destroyed
+        uint64_t uploaded; /// Bytes of pixel data sent to textures
+
+        inline int draw_calls() const
+        {
+            return copies + primitives + geometry;
+        }
+    };
+
+    Frame current = Frame();
+    Frame last = Frame();
+
+    int live_textures = 0;
+    uint64_t vram = 0;         /// Estimated bytes held by live textures
+    Texture *bound = nullptr;  /// Last texture drawn with
+
+    inline void bind(Texture *tx)
+    {
+        current.binds++;
+        if (tx != bound) {
+            current.switches++;
+            bound = tx;
+        }
+    }
+
+    inline void copy(Texture *tx)
+    {
+        current.copies++;
+        bind(tx);
+    }
+
+    inline void geometry(Texture *tx)
+    {
+        current.geometry++;
+        if (tx)
+            bind(tx);
+    }
+
+    inline void primitive()
+    {
+        current.primitives++;
+    }
+
+    inline void color()
+    {
+        current.colors++;
+    }
+
+    /// SDL rebinds on a target switch, so the next texture is a switch too.
+    inline void target()
+    {
+        current.targets++;
+        bound = nullptr;
+    }
+
+    inline void upload(uint64_t bytes)
+    {
+        current.uploaded += bytes;
+    }
+
+    /// Called once per presented frame.
+    inline void end_frame()
+    {
+        last = current;
+        current = Frame();
+    }
+};
+
+/// The process-wide counters.
+RenderStats &render_stats();
+
+/// Estimated size of a texture in video memory.
+uint64_t texture_bytes(Texture *tx);
+
+/// SDL_CreateTexture with accounting.
+Texture *create_texture(SDL_Renderer *r, uint32_t format, int access, int w, int h);
+
+/// SDL_CreateTextureFromSurface with accounting. The surface counts as uploaded.
+Texture *create_texture(SDL_Renderer *r, Surface *s);
+
+/// SDL_UpdateTexture with accounting. A null rect updates the whole texture.
+int update_texture(Texture *tx, const Rect *rect, const void *pixels, int pitch);
+
+/// SDL_DestroyTexture with accounting. Null is ignored.
+void destroy_texture(Texture *tx);
+
+};
+
+#endif
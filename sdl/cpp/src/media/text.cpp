@@ -1,43 +1,305 @@
+#include <algorithm>
+
 #include "text.hpp"
+#include "stats.hpp"
 
 namespace media {
 
-void Text::text(ObjectRef k, const char *str, Color c)
+/// Decodes the UTF-8 code point at s and advances past it.
+static inline uint32_t next_code_point(const char *&s)
 {
-    Rect dims;
-    SDL_Surface *t;
+    const unsigned char *u = (const unsigned char *) s;
+    uint32_t cp;
+    int len;
+
+    if (u[0] < 0x80) {
+        cp = u[0];
+        len = 1;
+    } else if ((u[0] & 0xE0) == 0xC0) {
+        cp = u[0] & 0x1F;
+        len = 2;
+    } else if ((u[0] & 0xF0) == 0xE0) {
+        cp = u[0] & 0x0F;
+        len = 3;
+    } else if ((u[0] & 0xF8) == 0xF0) {
+        cp = u[0] & 0x07;
+        len = 4;
+    } else {
+        s++;
+        return '?';
+    }
+
+    for (int i = 1; i < len; i++) {
+        if ((u[i] & 0xC0) != 0x80) {
+            // Truncated sequence
+            s += i;
+            return '?';
+        }
+        cp = (cp << 6) | (u[i] & 0x3F);
+    }
+
+    if (cp != 0)
+        s += len;
+    return cp;
+}
+
+/// Encodes a code point as a null terminated UTF-8 string.
+static inline void encode_code_point(uint32_t cp, char buf[5])
+{
+    if (cp < 0x80) {
+        buf[0] = cp;
+        buf[1] = '\0';
+    } else if (cp < 0x800) {
+        buf[0] = 0xC0 | (cp >> 6);
+        buf[1] = 0x80 | (cp & 0x3F);
+        buf[2] = '\0';
+    } else if (cp < 0x10000) {
+        buf[0] = 0xE0 | (cp >> 12);
+        buf[1] = 0x80 | ((cp >> 6) & 0x3F);
+        buf[2] = 0x80 | (cp & 0x3F);
+        buf[3] = '\0';
+    } else {
+        buf[0] = 0xF0 | (cp >> 18);
+        buf[1] = 0x80 | ((cp >> 12) & 0x3F);
+        buf[2] = 0x80 | ((cp >> 6) & 0x3F);
+        buf[3] = 0x80 | (cp & 0x3F);
+        buf[4] = '\0';
+    }
+}
+
+/*
+ * =============================================================================
+ * Glyph Cache
+ * =============================================================================
+ */
+
+// Fonts are shared through the registry, keyed by path and size.
+Text::Text(State &m, std::string font_path):
+    Text(m, m.assets.font(font_path, DEFAULT_SIZE)) {}
+
+Text::Text(State &m, Assets::Ref font_ref): m(m), font_ref(font_ref)
+{
+    if (!font_ref) {
+        printf("Font not loaded\n");
+        return;
+    }
+    font = font_ref->font;
+    cache_std_glyphs();
+}
+
+Text::~Text()
+{
+    destroy_texture(glyph_tx);
+    for (auto &i: ext_glyphs)
+        destroy_texture(i.second.texture);
+}
+
+/**
+ * Glyphs are rendered white and laid out in a single row. Colour is applied
+ * when painting.
+ */
+void Text::cache_std_glyphs()
+{
+    SDL_Surface *glyphs[128] = { nullptr };
+    Color white = {255, 255, 255, 255};
+    char buf[2] = {0, 0};
+    int w = 0, h = 0;
+
+    line_height = TTF_FontLineSkip(font);
+
+    for (int i = 0; i < 128; i++) {
+        std_glyph_offsets[i] = (Rect) {0, 0, 0, 0};
+
+        if (i < ' ' || i == 127)
+            continue;
+
+        buf[0] = i;
+        glyphs[i] = TTF_RenderUTF8_Blended(font, buf, white);
+        if (!glyphs[i])
+            continue;
+
+        w += glyphs[i]->w;
+        if (glyphs[i]->h > h)
+            h = glyphs[i]->h;
+    }
+
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    int x = 0;
+
+    for (int i = 0; i < 128; i++) {
+        if (!glyphs[i])
+            continue;
+
+        Rect d = { x, 0, glyphs[i]->w, glyphs[i]->h };
+        // Copy alpha as is instead of blending onto the empty atlas.
+        SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(glyphs[i], nullptr, atlas, &d);
+        std_glyph_offsets[i] = d;
+        x += d.w;
+
+        SDL_FreeSurface(glyphs[i]);
+    }
+
+    glyph_tx = create_texture(m.r, atlas);
+    SDL_SetTextureBlendMode(glyph_tx, SDL_BLENDMODE_BLEND);
+    SDL_FreeSurface(atlas);
+}
+
+Text::Glyph Text::cache_ext_glyph(uint32_t glyph)
+{
+    Glyph k = { nullptr, {0, 0, 0, 0} };
+    char buf[5];
+
+    encode_code_point(glyph, buf);
+    SDL_Surface *t = TTF_RenderUTF8_Blended(font, buf, (Color) {255, 255, 255, 255});
+
+    // Glyphs that fail to render are cached as empty so we don't retry them
+    // every frame.
+    if (t) {
+        k.texture = create_texture(m.r, t);
+        SDL_SetTextureBlendMode(k.texture, SDL_BLENDMODE_BLEND);
+        k.src = (Rect) {0, 0, t->w, t->h};
+        SDL_FreeSurface(t);
+    }
+
+    ext_glyphs[glyph] = k;
+    return k;
+}
+
+void Text::draw(Graphics &g, const char *str, Point pos, Color c)
+{
+    Rect dest = { pos.x, pos.y, 0, 0 };
+    uint32_t cp;
+
+    if (!str)
+        return;
+
+    while ((cp = next_code_point(str)) != 0) {
+        if (cp == '\n') {
+            dest.x = pos.x;
+            dest.y += line_height + line_spacing;
+            continue;
+        }
+
+        Glyph k = get_glyph(cp);
+        if (k.src.w == 0)
+            continue;
+
+        dest.w = k.src.w;
+        dest.h = k.src.h;
+        g.paint(k.texture, k.src, dest, c);
+        dest.x += k.src.w + glyph_spacing;
+    }
+}
+
+void Text::draw(Graphics &g, const char *str, Point pos)
+{
+    this->draw(g, str, pos, (Color) {255, 255, 255, 255});
+}
+
+Size Text::size(const char *str)
+{
+    Size k = { 0, line_height };
+    int x = 0;
+    uint32_t cp;
+
+    if (!str)
+        return k;
 
+    while ((cp = next_code_point(str)) != 0) {
+        if (cp == '\n') {
+            x = 0;
+            k.h += line_height + line_spacing;
+            continue;
+        }
+
+        Glyph t = get_glyph(cp);
+        if (t.src.w == 0)
+            continue;
+
+        if (x > 0)
+            x += glyph_spacing;
+        x += t.src.w;
+        if (x > k.w)
+            k.w = x;
+    }
+
+    return k;
+}
+
+/*
+ * =============================================================================
+ * Text Objects
+ * =============================================================================
+ */
+
+/**
+ * Paints the glyphs into a texture through g, so its batching, paint target
+ * and clip state stay consistent. Everything g was set to is restored
+ * afterwards. The object's texture is painted over if it has the right size,
+ * and only replaced otherwise.
+ */
+void Text::text(Graphics &g, ObjectRef k, const char *str, Color c)
+{
     // Empty strings are undefined behaviour.
-    if (!str || *str == '\0') {
-        t = TTF_RenderText_Solid(font, " ", c);
+    if (!str || *str == '\0')
+        str = " ";
+
+    // Text without visible glyphs, e.g. "\n", still needs a texture.
+    Size s = this->size(str);
+    int tw = std::max(s.w, 1), th = std::max(s.h, 1);
+    int access, w, h;
+    Texture *ttx;
+
+    if (k.texture && !k.shared &&
+        SDL_QueryTexture(k.texture, nullptr, &access, &w, &h) == 0 &&
+        access == SDL_TEXTUREACCESS_TARGET && w == tw && h == th) {
+        ttx = k.texture;
     } else {
-        t = TTF_RenderText_Solid(font, str, c);
+        ttx = create_texture(m.r, SDL_PIXELFORMAT_ARGB8888,
+                             SDL_TEXTUREACCESS_TARGET, tw, th);
     }
-    
-    SDL_GetClipRect(t, &dims);
-    PRINTRECT(dims);
-    k.set_rect(dims);
-    Texture *ttx = SDL_CreateTextureFromSurface(m.r, t);
-    int a, b;
-    SDL_QueryTexture(ttx, nullptr, nullptr, &a, &b);
 
-    SDL_FreeSurface(t);
-    k.set(ttx);
+    if (!ttx) {
+        printf("Text not rendered: %s\n", SDL_GetError());
+        return;
+    }
+
+    Texture *prev_target = g.get_paint_target();
+    Point prev_origin = g.get_origin();
+    Color prev_color = g.get_color();
+    Rect prev_clip;
+    bool prev_clipped = g.get_clip(prev_clip);
+
+    SDL_SetTextureBlendMode(ttx, SDL_BLENDMODE_BLEND);
+    g.set_paint_target(ttx);
+    g.set_origin((Point) {0, 0});
+    g.clear((Color) {0, 0, 0, 0});
+    draw(g, str, (Point) {0, 0}, c);
+
+    g.set_paint_target(prev_target);
+    g.set_origin(prev_origin);
+    g.set_clip(prev_clipped ? &prev_clip : nullptr);
+    g.set_color(prev_color);
+
+    k.set_rect((Rect) {0, 0, s.w, s.h});
+    if (ttx != k.texture)
+        k.set(ttx);
 }
 
-void Text::text(ObjectRef k, const char *str)
+void Text::text(Graphics &g, ObjectRef k, const char *str)
 {
-    this->text(k, str, (Color) {255, 255, 255, 255});
+    this->text(g, k, str, (Color) {255, 255, 255, 255});
 }
 
-void Text::text(ObjectRef k, std::string str, Color c)
+void Text::text(Graphics &g, ObjectRef k, std::string str, Color c)
 {
-    this->text(k, str.c_str(), c);
+    this->text(g, k, str.c_str(), c);
 }
 
-void Text::text(ObjectRef k, std::string str)
+void Text::text(Graphics &g, ObjectRef k, std::string str)
 {
-    this->text(k, str.c_str());
+    this->text(g, k, str.c_str());
 }
 
 void Text::wrap_text(ObjectRef k, const char *str, Color c, Rect wrap_rect)
@@ -54,7 +316,7 @@ void Text::wrap_text(ObjectRef k, const char *str, Color c, Rect wrap_rect)
     
     SDL_GetClipRect(t, &dims);
     k.set_rect(dims);
-    SDL_Texture *ttx = SDL_CreateTextureFromSurface(this->m.r, t);
+    SDL_Texture *ttx = create_texture(this->m.r, t);
     SDL_FreeSurface(t);
     k.texture = ttx;
 }
@@ -7,54 +7,73 @@
 #include "common.hpp"
 #include "media.hpp"
 #include "object.hpp"
+#include "assets.hpp"
 
 namespace media {
 
 /**
  * Caching monospace TTF/Bitmap font renderer.
+ *
+ * Printable ASCII is rasterised once into a single texture. Any other code
+ * point is rasterised the first time it is drawn and kept afterwards. draw()
+ * then paints one quad per glyph, so changing a string costs no rendering or
+ * texture uploads.
  */
 
 class Text {
     public:
-        enum class FontDataType {
-            FONT_DATA_STANDARD,
-            FONT_DATA_IMAGE
+        /// Location of a cached glyph.
+        struct Glyph {
+            Texture *texture;
+            Rect src;
         };
 
     protected:
         State &m;
         // We cache any glyphs we use.
-        TTF_Font *font;
-        Texture *glyph_tx;
+        Assets::Ref font_ref;
+        TTF_Font *font = nullptr;
+        Texture *glyph_tx = nullptr;
         Rect std_glyph_offsets[128]; // Usually we don't really access glyphs
                                      // above 128
-        std::map<uint32_t, Texture *> ext_glyphs; // Any extra glyphs we need
+        std::map<uint32_t, Glyph> ext_glyphs; // Any extra glyphs we need
 
-        inline Texture *get_glyph(uint32_t glyph);
+        int glyph_spacing = 0;
+        int line_spacing  = 0;
+        int line_height   = 0;
+
+        void cache_std_glyphs();
+        Glyph cache_ext_glyph(uint32_t glyph);
+        inline Glyph get_glyph(uint32_t glyph);
 
     public:
-        void init(FontDataType ft, char *font_path);
+        /// Point size fonts are opened at, here and by State.
+        static const int DEFAULT_SIZE = 14;
+
+        Text(State &m, std::string font_path);
+
+        /// Caches the glyphs of an already open font, e.g. State's.
+        Text(State &m, Assets::Ref font_ref);
+
+        ~Text();
 
-        Text(State &m, FontDataType ft, std::string font_path): m(m)
-        {
-            font = TTF_OpenFont(font_path.c_str(), 16);
-            if (!font) {
-                printf("Font not loaded\n");
-            }
-        }
+        void set_glyph_spacing(int spacing) { glyph_spacing = spacing; }
+        void set_line_spacing(int spacing)  { line_spacing = spacing; }
+        int get_line_height()               { return line_height + line_spacing; }
 
-        ~Text()
-        {
-            TTF_CloseFont(font);
-        }
+        /// Draws a UTF-8 string from cached glyphs, one quad per glyph.
+        void draw(Graphics &g, const char *str, Point pos, Color c);
+        void draw(Graphics &g, const char *str, Point pos);
 
-        void set_glyph_spacing(int spacing) {}
-        void set_line_spacing(int spacing) {}
+        /// Size the string would occupy when drawn.
+        Size size(const char *str);
 
-        void text(ObjectRef k, const char *str, Color c);
-        void text(ObjectRef k, const char *str);
-        void text(ObjectRef k, std::string str, Color c);
-        void text(ObjectRef k, std::string str);
+        /// Composes the string into a texture of its own, for callers that
+        /// need an Object. Prefer draw(), which allocates nothing.
+        void text(Graphics &g, ObjectRef k, const char *str, Color c);
+        void text(Graphics &g, ObjectRef k, const char *str);
+        void text(Graphics &g, ObjectRef k, std::string str, Color c);
+        void text(Graphics &g, ObjectRef k, std::string str);
 
         void wrap_text(ObjectRef k, const char *str, Color c, Rect wrap_rect);
         void wrap_text(ObjectRef k, const char *str, Rect wrap_rect);
@@ -62,6 +81,18 @@ class Text {
         void wrap_text(ObjectRef k, std::string str, Rect wrap_rect);
 };
 
+inline Text::Glyph Text::get_glyph(uint32_t glyph)
+{
+    if (glyph < 128)
+        return (Glyph) { glyph_tx, std_glyph_offsets[glyph] };
+
+    auto i = ext_glyphs.find(glyph);
+    if (i != ext_glyphs.end())
+        return i->second;
+
+    return cache_ext_glyph(glyph);
+}
+
 };
 
 #endif
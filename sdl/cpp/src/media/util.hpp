@@ -1,6 +1,8 @@
 #ifndef MEDIA_UTIL_H
 #define MEDIA_UTIL_H
 
+#include <vector>
+
 #include "common.hpp"
 
 namespace media {
@@ -53,6 +55,59 @@ static inline bool point_in_rect(int x, int y, Rect rect)
             (x) <= (rect).x + (rect).w && (y) <= (rect).y + (rect).h);
 }
 
+/// True if the rectangles share some area.
+static inline bool rects_overlap(const Rect &a, const Rect &b)
+{
+    return a.x < b.x + b.w && b.x < a.x + a.w &&
+           a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+/// True if the rectangles overlap or share an edge.
+static inline bool rect_touches(Rect a, Rect b)
+{
+    return a.x <= b.x + b.w && b.x <= a.x + a.w &&
+           a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+static inline Rect rect_union(Rect a, Rect b)
+{
+    int x1 = a.x < b.x ? a.x : b.x;
+    int y1 = a.y < b.y ? a.y : b.y;
+    int x2 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    int y2 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+
+    return (Rect) { x1, y1, x2 - x1, y2 - y1 };
+}
+
+/**
+ * Merges touching rectangles in place until no two of them touch. Used for
+ * dirty regions, where the list is short and a quadratic pass is fine.
+ */
+static inline void merge_rects(std::vector<Rect> &k)
+{
+    size_t i = 0;
+
+    while (i < k.size()) {
+        bool merged = false;
+
+        for (size_t j = i + 1; j < k.size(); j++) {
+            if (rect_touches(k[i], k[j])) {
+                k[i] = rect_union(k[i], k[j]);
+                k[j] = k.back();
+                k.pop_back();
+                merged = true;
+                break;
+            }
+        }
+
+        // A grown rectangle may now touch earlier ones too.
+        if (merged)
+            i = 0;
+        else
+            i++;
+    }
+}
+
 };
 
 };
@@ -27,8 +27,10 @@ class Scene {
         virtual void event()  = 0;
         virtual void update() = 0;
 
-        // virtual void activate() = 0;
-        // virtual void deactivate() = 0;
+        // Called when the scene is switched to and away from, so that its
+        // event subscriptions only run while it is shown.
+        virtual void activate() {}
+        virtual void deactivate() {}
 
         virtual inline bool initialized()
         {
@@ -6,7 +6,6 @@
 #include "ui/ui.hpp"
 
 #include <vector>
-#include <deque>
 #include <string>
 #include <stdlib.h>
 #include <time.h>
@@ -28,9 +27,16 @@ class GameScene : public Scene {
         Timer bullet_timer;
 
         Rect player = {0, 0, 40, 40};
+        Rect prev_player = player; /// Player before the last update
         Rect enemy = {0, 0, 20, 20};
         Rect bullet_dims = {0, 0, 10, 10};
+        static const int max_bullets = 20;
 
+        Loader &l;
+        Loader::Handle shoot_req;
+        Loader::Handle song_req;
+        Assets::Ref shoot_asset;
+        Assets::Ref song_asset;
         Sound shoot_snd;
         Music song;
 
@@ -40,17 +46,21 @@ class GameScene : public Scene {
         int yaccn = 0;
         int cap = 10;
         int friction = 1;
-        std::deque<Rect> bullets;
-        int num_bullets = 0;
+        ProjectilePool bullets;
         bool firing = false;
         bool motion = false;
         bool enemy_in = false;
+        std::vector<int> subs; /// EventBus subscriptions
+
+        void on_key(uint32_t type, SDL_Keycode key, std::function<void ()> f);
 
     public:
-        GameScene(State &m, Graphics &g, SceneState &s):
+        GameScene(State &m, Graphics &g, SceneState &s, Loader &l):
             m(m), g(g), s(s), timer(1000), motion_timer(10), bullet_timer(50),
-            shoot_snd("assets/shoot.wav"),
-            song("assets/song.xm"),
+            l(l),
+            bullets(max_bullets, (Size) {bullet_dims.w, bullet_dims.h}),
+            shoot_req(l.sound("assets/shoot.wav")),
+            song_req(l.music("assets/song.xm")),
             w(m, g, "top", 0, (Rect) {0, 0, 800, 600}) {}
         ~GameScene() {};
         void init();
@@ -58,12 +68,15 @@ class GameScene : public Scene {
         void event();
         void update();
         void close();
+        void activate();
+        void deactivate();
 };
 
 
 void GameScene::init()
 {
-    srand(time(nullptr));
+    srand(m.seed);
+    bullets.set_bounds((Rect) {0, 0, 800, 600});
     w.geo.add(BOTTOMRIGHT, 0, 0);
     c = &w.add<ui::Frame>("Menu", 0, (Rect) {0, 0, 400, 100});
     c->add<ui::Label>("In Game Scene");
@@ -74,17 +87,51 @@ void GameScene::init()
     c->hide();
     song.set_volume(40);
     // song.play();
+
+    on_key(SDL_KEYDOWN, SDLK_RIGHT, [this]() { xaccn += 2; });
+    on_key(SDL_KEYUP,   SDLK_RIGHT, [this]() { xaccn -= 2; });
+    on_key(SDL_KEYDOWN, SDLK_LEFT,  [this]() { xaccn -= 2; });
+    on_key(SDL_KEYUP,   SDLK_LEFT,  [this]() { xaccn += 2; });
+    on_key(SDL_KEYDOWN, SDLK_UP,    [this]() { yaccn -= 2; });
+    on_key(SDL_KEYUP,   SDLK_UP,    [this]() { yaccn += 2; });
+    on_key(SDL_KEYDOWN, SDLK_DOWN,  [this]() { yaccn += 2; });
+    on_key(SDL_KEYUP,   SDLK_DOWN,  [this]() { yaccn -= 2; });
+    on_key(SDL_KEYDOWN, SDLK_SPACE, [this]() { firing = true; });
+    on_key(SDL_KEYUP,   SDLK_SPACE, [this]() { firing = false; });
+    on_key(SDL_KEYUP,   SDLK_m, [this]() {
+        if (c->shown())
+            c->hide();
+        else
+            c->show();
+    });
+    deactivate();
+
     init_flag = true;
 }
 
+/// Subscribes f to presses or releases of a key, ignoring key repeat.
+void GameScene::on_key(uint32_t type, SDL_Keycode key, std::function<void ()> f)
+{
+    subs.push_back(m.events.subscribe_key(type, key,
+        [f](const SDL_Event &e) {
+            if (e.key.repeat == 0)
+                f();
+        }));
+}
+
 void GameScene::draw()
 {
     w.draw();
+
+    // Interpolate between the last two fixed updates.
+    Rect p = player;
+    p.x = prev_player.x + (player.x - prev_player.x) * m.alpha;
+    p.y = prev_player.y + (player.y - prev_player.y) * m.alpha;
+
     g.set_color(255, 255, 255, 255);
-    g.rect(player);
+    g.rect(p);
     g.set_color(255, 128, 0, 255);
-    for (auto &i :bullets)
-        g.frect(i);
+    bullets.draw(g);
 
     if (enemy_in == true) {
         g.set_color(0x41, 0x83, 0xF5, 0xFF);
@@ -94,78 +141,19 @@ void GameScene::draw()
 
 void GameScene::event()
 {
-    if (m.e.key.repeat == 0) {
-        switch (m.e.type) {
-        case SDL_KEYUP:
-            // printf("%d\n", m.e.key.keysym.sym);
-            switch (m.e.key.keysym.sym) {
-            case SDLK_RIGHT:
-                xaccn -= 2;
-                break;
-
-            case SDLK_LEFT:
-                xaccn -= -2;
-                break;
-
-            case SDLK_UP:
-                yaccn -= -2;
-                break;
-
-            case SDLK_DOWN:
-                yaccn -= 2;
-                break;
-            case SDLK_SPACE:
-                firing = false;
-                break;
-
-            case SDLK_m:
-                if (c->shown())
-                    c->hide();
-                else
-                    c->show();
-                break;
-            }
-            break;
-
-        case SDL_KEYDOWN:
-            switch (m.e.key.keysym.sym) {
-            case SDLK_RIGHT:
-                xaccn += 2;
-                break;
-
-            case SDLK_LEFT:
-                xaccn += -2;
-                break;
-
-            case SDLK_UP:
-                yaccn += -2;
-                break;
-
-            case SDLK_DOWN:
-                yaccn += 2;
-                break;
-
-            case SDLK_SPACE:
-                /*if (firing == false) {
-                    bullet = Util::rect_align(player, bullet, CENTER, 0, 0);
-                    if (num_bullets < 20) {
-                        num_bullets++;
-                    }
-                    firing = true;
-                }*/
-                firing = true;
-                break;
-            }
-            break;
-        }
-    }
-
     w.event();
 }
 
 void GameScene::update()
 {
     // printf("called\n");
+    // Assets arrive from the loader in the background.
+    if (shoot_req && (shoot_asset = l.adopt(shoot_snd, shoot_req)))
+        shoot_req.reset();
+    if (song_req && (song_asset = l.adopt(song, song_req)))
+        song_req.reset();
+
+    prev_player = player;
     timer.update(m.delta);
     motion_timer.update(m.delta);
     bullet_timer.update(m.delta);
@@ -173,16 +161,12 @@ void GameScene::update()
 
     if (timer.done()) {
         counter_val++;
-        counter->set_label(std::to_string(counter_val) + " delta: " + std::to_string(m.delta));
+        counter->set_labelf("%d delta: %u", counter_val, m.delta);
     }
 
-    info->set_label("Xvel: " + std::to_string(xvel) + " " +    \
-                    "Yvel: " + std::to_string(yvel) + " " +    \
-                    "Xaccn: " + std::to_string(xaccn) + " " +  \
-                    "Yaccn: " + std::to_string(yaccn) + " " +  \
-                    "Px: "   + std::to_string(player.x) + " " +\
-                    "Py: "   + std::to_string(player.y));
-    info2->set_label("M: " + std::to_string(motion) + " Bs: " + std::to_string(bullets.size()));
+    info->set_labelf("Xvel: %d Yvel: %d Xaccn: %d Yaccn: %d Px: %d Py: %d",
+                     xvel, yvel, xaccn, yaccn, player.x, player.y);
+    info2->set_labelf("M: %d Bs: %d", motion, bullets.count());
 
     uint32_t x;
 
@@ -208,18 +192,12 @@ void GameScene::update()
         //}
     }
 
-    if (firing && num_bullets < 20 && bullet_timer.done()) {
-        num_bullets++;
-        bullets.push_back(util::rect_align(player, bullet_dims, CENTER, 0, 0));
-        shoot_snd.play(0);
-    }
-    
-    for (auto &i: bullets) {
-        i.y -= 10;
-        if (bullets.front().y < 0) {
-            bullets.pop_front();
-            num_bullets--;
-        }
+    bullets.update();
+
+    if (firing && bullet_timer.done()) {
+        Rect b = util::rect_align(player, bullet_dims, CENTER, 0, 0);
+        if (bullets.spawn(b.x, b.y, 0, -10, 600))
+            shoot_snd.play(0);
     }
 
     if (enemy_in == false) {
@@ -238,6 +216,24 @@ void GameScene::update()
 
 void GameScene::close()
 {
+    for (int id: subs)
+        m.events.unsubscribe(id);
+    subs.clear();
+}
+
+void GameScene::activate()
+{
+    for (int id: subs)
+        m.events.enable(id, true);
+}
+
+/// The releases of keys held now won't be seen, so they are released here.
+void GameScene::deactivate()
+{
+    for (int id: subs)
+        m.events.enable(id, false);
+    xaccn = yaccn = 0;
+    firing = false;
 }
 
 #endif
@@ -47,6 +47,7 @@ void QuitScene::init()
     f->add<ui::Button>("z");
     f->add<ui::Button>("z");
     f->add<ui::Button>("z");
+    f->set_cached(true);
     w.refresh();
     init_flag = true;
 }
@@ -62,9 +63,9 @@ void QuitScene::event()
 {
     w.event();
 
-    if (yes->is_down()) {
+    if (yes->clicked()) {
         m.active = false;
-    }  else if (no->is_down()) {
+    }  else if (no->clicked()) {
         printf("active: %d\n", quitmode);
         this->quitmode = false;
         printf("active: %d\n", quitmode);
@@ -13,6 +13,7 @@ class TitleScene : public Scene {
         Graphics &g;
         SceneState &s;
         ui::TopLevel w;
+        std::vector<int> subs; /// EventBus subscriptions
 
     public:
         TitleScene(State &m, Graphics &g, SceneState &s):
@@ -24,6 +25,8 @@ class TitleScene : public Scene {
         void event();
         void update();
         void close();
+        void activate();
+        void deactivate();
 };
 
 void TitleScene::init()
@@ -31,6 +34,11 @@ void TitleScene::init()
     w.geo.add(CENTER, 0, 0);
     w.add<ui::Label>("Shoot Game");
     w.refresh();
+
+    subs.push_back(m.events.subscribe_key(SDL_KEYUP, SDLK_SPACE,
+        [this](const SDL_Event &e) { s = SCENE_GAME; }));
+    deactivate();
+
     init_flag = true;
 }
 
@@ -43,14 +51,6 @@ void TitleScene::draw()
 
 void TitleScene::event()
 {
-    switch (m.e.type) {
-    case SDL_KEYUP:
-        switch (m.e.key.keysym.sym) {
-        case SDLK_SPACE:
-            s = SCENE_GAME;
-        }
-        break;
-    }
     w.event();
 }
 
@@ -61,7 +61,22 @@ void TitleScene::update()
 
 void TitleScene::close()
 {
+    for (int id: subs)
+        m.events.unsubscribe(id);
+    subs.clear();
     init_flag = false;
 }
 
+void TitleScene::activate()
+{
+    for (int id: subs)
+        m.events.enable(id, true);
+}
+
+void TitleScene::deactivate()
+{
+    for (int id: subs)
+        m.events.enable(id, false);
+}
+
 #endif
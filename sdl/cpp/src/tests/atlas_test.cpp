@@ -0,0 +1,112 @@
+/*
+ * Tests for media::Atlas packing, on a headless State.
+ *
+ *     atlastest [font path]
+ */
+
+#include <vector>
+
+#include "media/media.hpp"
+#include "test.hpp"
+
+using namespace media;
+
+static const int PAGE = 256;
+static const int SPACING = 1;
+
+struct Placed {
+    Texture *page;
+    Rect region;
+};
+
+/// Deterministic sizes, so that a failure can be reproduced.
+static inline int next_size(uint32_t &seed, int max)
+{
+    seed = seed * 1103515245 + 12345;
+    return 1 + (seed >> 16) % max;
+}
+
+/// Many images of mixed sizes fill several pages, and every region lies
+/// within its page, apart from the others by at least the spacing.
+static void test_pack(State &m)
+{
+    Atlas a(m, PAGE, PAGE, SPACING);
+    std::vector<Placed> placed;
+    uint32_t seed = 1;
+
+    for (int i = 0; i < 500; i++) {
+        int w = next_size(seed, 64), h = next_size(seed, 64);
+        Surface *s = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32,
+                                                    SDL_PIXELFORMAT_ARGB8888);
+        Placed k;
+
+        CHECK(a.place(s, k.page, k.region));
+        CHECK(k.region.w == w && k.region.h == h);
+        placed.push_back(k);
+        SDL_FreeSurface(s);
+    }
+
+    CHECK(a.page_count() > 1);
+
+    int bad_bounds = 0, overlaps = 0;
+
+    for (size_t i = 0; i < placed.size(); i++) {
+        const Rect &r = placed[i].region;
+
+        if (r.x < 0 || r.y < 0 || r.x + r.w > PAGE || r.y + r.h > PAGE)
+            bad_bounds++;
+
+        Rect padded = { r.x, r.y, r.w + SPACING, r.h + SPACING };
+
+        for (size_t j = i + 1; j < placed.size(); j++) {
+            if (placed[i].page != placed[j].page)
+                continue;
+
+            const Rect &q = placed[j].region;
+            Rect other = { q.x, q.y, q.w + SPACING, q.h + SPACING };
+            if (util::rects_overlap(padded, other))
+                overlaps++;
+        }
+    }
+
+    CHECK(bad_bounds == 0);
+    CHECK(overlaps == 0);
+}
+
+/// Images that can't share a page are refused by place(), and add() gives
+/// them a texture of their own instead.
+static void test_too_big(State &m)
+{
+    Atlas a(m, PAGE, PAGE, SPACING);
+    Surface *s = SDL_CreateRGBSurfaceWithFormat(0, PAGE, 8, 32,
+                                                SDL_PIXELFORMAT_ARGB8888);
+    Texture *page = nullptr;
+    Rect region;
+    ClipObject k;
+
+    CHECK(!a.place(s, page, region));
+    CHECK(a.page_count() == 0);
+
+    a.add(k, s);
+    CHECK(k.texture != nullptr && !k.shared);
+    CHECK(k.dest_rect.w == PAGE && k.dest_rect.h == 8);
+
+    SDL_FreeSurface(s);
+}
+
+int main(int argc, char **argv)
+{
+    const char *font_path = argc > 1 ? argv[1] : "assets/font.otb";
+
+    try {
+        State m(320, 240, 0, "AtlasTest", font_path, STATE_HEADLESS);
+
+        test_pack(m);
+        test_too_big(m);
+    } catch (int err_code) {
+        fprintf(stderr, "[TEST] Exiting with error code %d\n", err_code);
+        return 1;
+    }
+
+    return test_result("atlas");
+}
@@ -0,0 +1,214 @@
+/*
+ * Tests for the entity component system in ecs.hpp.
+ *
+ *     ecstest
+ */
+
+#include <vector>
+
+#include "ecs.hpp"
+#include "test.hpp"
+
+using namespace ecs;
+
+struct Position {
+    float x, y;
+};
+
+struct Velocity {
+    float x, y;
+};
+
+struct Tag {
+    int value;
+};
+
+/// Spawned entities are alive with the given components, and handles of
+/// destroyed ones stay dead after their index is reused.
+static void test_spawn_destroy()
+{
+    World w;
+
+    Entity a = w.spawn(Position {1, 2});
+    Entity b = w.spawn(Position {3, 4}, Velocity {1, 0});
+
+    CHECK(w.size() == 2);
+    CHECK(w.alive(a) && w.alive(b));
+    CHECK(w.has<Position>(a) && !w.has<Velocity>(a));
+    CHECK(w.get<Position>(b)->x == 3 && w.get<Velocity>(b)->x == 1);
+
+    w.destroy(a);
+    CHECK(!w.alive(a));
+    CHECK(w.get<Position>(a) == nullptr);
+    CHECK(w.size() == 1);
+
+    Entity c = w.spawn(Position {5, 6});
+    CHECK(c.index == a.index && c != a);
+    CHECK(!w.alive(a) && w.alive(c));
+    CHECK(w.get<Position>(c)->y == 6);
+
+    // Destroying twice is harmless.
+    w.destroy(a);
+    CHECK(w.size() == 2);
+}
+
+/// Adding and removing components moves entities between archetypes,
+/// keeping the components they still have and fixing up the moved rows.
+static void test_add_remove()
+{
+    World w;
+    std::vector<Entity> k;
+
+    for (int i = 0; i < 10; i++)
+        k.push_back(w.spawn(Position {(float) i, 0}));
+
+    w.add(k[3], Velocity {7, 0});
+    CHECK(w.has<Velocity>(k[3]));
+    CHECK(w.get<Position>(k[3])->x == 3);
+
+    // The last row was moved into the hole k[3] left.
+    CHECK(w.get<Position>(k[9])->x == 9);
+
+    // Adding a present component overwrites it.
+    w.add(k[3], Velocity {8, 0});
+    CHECK(w.get<Velocity>(k[3])->x == 8);
+
+    w.remove<Velocity>(k[3]);
+    CHECK(!w.has<Velocity>(k[3]));
+    CHECK(w.get<Position>(k[3])->x == 3);
+
+    w.remove<Position>(k[4]);
+    CHECK(w.alive(k[4]) && !w.has<Position>(k[4]));
+
+    for (int i = 0; i < 10; i++) {
+        if (i != 4)
+            CHECK(w.get<Position>(k[i])->x == i);
+    }
+}
+
+/// each() and each_chunk() visit every matching entity exactly once, across
+/// archetypes and chunks, and see archetypes created after the query.
+static void test_query()
+{
+    World w;
+    Query<Position, Velocity> q(w);
+    const int n = 5000; // Several chunks
+
+    for (int i = 0; i < n; i++) {
+        if (i % 2)
+            w.spawn(Position {0, 0}, Velocity {1, 2});
+        else
+            w.spawn(Position {0, 0});
+    }
+    w.spawn(Position {0, 0}, Velocity {1, 2}, Tag {1});
+
+    CHECK(q.count() == n / 2 + 1);
+
+    int visited = 0;
+    q.each([&](Entity e, Position &p, Velocity &v) {
+        p.x += v.x;
+        p.y += v.y;
+        visited++;
+    });
+    CHECK(visited == n / 2 + 1);
+
+    int chunks = 0;
+    visited = 0;
+    q.each_chunk([&](int count, Entity *e, Position *p, Velocity *v) {
+        for (int i = 0; i < count; i++) {
+            p[i].x += v[i].x;
+            p[i].y += v[i].y;
+        }
+        visited += count;
+        chunks++;
+    });
+    CHECK(visited == n / 2 + 1);
+    CHECK(chunks > 1);
+
+    bool moved = true;
+    w.each<Position, Velocity>([&](Entity e, Position &p, Velocity &v) {
+        moved = moved && p.x == 2 && p.y == 4;
+    });
+    CHECK(moved);
+
+    int still = 0;
+    w.each<Position>([&](Entity e, Position &p) {
+        if (p.x == 0)
+            still++;
+    });
+    CHECK(still == n / 2);
+}
+
+/// Structural changes recorded while iterating apply afterwards, in order.
+static void test_commands()
+{
+    World w;
+    CommandBuffer &cmds = w.commands();
+    std::vector<Entity> k;
+
+    for (int i = 0; i < 100; i++)
+        k.push_back(w.spawn(Position {(float) i, 0}));
+
+    w.each<Position>([&](Entity e, Position &p) {
+        if ((int) p.x % 2)
+            cmds.destroy(e);
+        else if ((int) p.x % 4 == 0)
+            cmds.add(e, Velocity {1, 0});
+        if (p.x == 0)
+            cmds.spawn(Position {-1, 0}, Tag {1});
+    });
+
+    // Nothing happens until the buffer is applied.
+    CHECK(w.size() == 100);
+    CHECK(!cmds.empty());
+
+    cmds.apply(w);
+    CHECK(cmds.empty());
+    CHECK(w.size() == 51);
+    CHECK(!w.alive(k[1]) && w.alive(k[2]));
+    CHECK(w.has<Velocity>(k[4]) && !w.has<Velocity>(k[2]));
+    CHECK((Query<Position, Tag>(w).count() == 1));
+
+    // Removing and destroying in the same buffer.
+    cmds.remove<Velocity>(k[4]);
+    cmds.destroy(k[8]);
+    cmds.apply(w);
+    CHECK(!w.has<Velocity>(k[4]) && w.alive(k[4]));
+    CHECK(!w.alive(k[8]));
+    CHECK((Query<Position, Velocity>(w).count() == 23));
+}
+
+/// The scheduler applies commands between systems, so a later system sees
+/// what an earlier one spawned.
+static void test_scheduler()
+{
+    World w;
+    Scheduler s;
+    int seen = -1;
+
+    s.add("spawn", [](World &w, float dt) {
+        w.commands().spawn(Tag {1});
+    });
+    int id = s.add("count", [&](World &w, float dt) {
+        seen = Query<Tag>(w).count();
+    });
+
+    s.run(w, 0);
+    CHECK(seen == 1);
+
+    s.enable(id, false);
+    s.run(w, 0);
+    CHECK(seen == 1);
+    CHECK(w.size() == 2);
+}
+
+int main(int argc, char **argv)
+{
+    test_spawn_destroy();
+    test_add_remove();
+    test_query();
+    test_commands();
+    test_scheduler();
+
+    return test_result("ecs");
+}
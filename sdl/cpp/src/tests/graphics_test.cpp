@@ -0,0 +1,108 @@
+/*
+ * Rendering tests for media::Graphics, on a headless State.
+ *
+ *     graphicstest [font path]
+ */
+
+#include <vector>
+
+#include "media/media.hpp"
+#include "ui/ui.hpp"
+#include "test.hpp"
+
+using namespace media;
+
+static const uint32_t RED = 0xFF0000;
+
+/// A solid red square, painted with a plain copy.
+class Swatch : public ui::Widget {
+    protected:
+        Object o;
+
+    public:
+        Swatch(State &m, Graphics &g, std::string label, int options = 0):
+            Widget(m, g, label, options)
+        {
+            std::vector<uint32_t> px(16 * 16, 0xFFFF0000);
+            Texture *tx = create_texture(m.r, SDL_PIXELFORMAT_ARGB8888,
+                                         SDL_TEXTUREACCESS_STATIC, 16, 16);
+            update_texture(tx, nullptr, px.data(), 16 * sizeof(uint32_t));
+            o.set(tx);
+            dims = (Rect) { 0, 0, 16, 16 };
+            set_measured((Size) { 16, 16 });
+        }
+
+        void draw()
+        {
+            o.set_rect(dims);
+            g.paint(o);
+        }
+
+        void refresh() {}
+        bool event()   { return true; }
+        bool update()  { return true; }
+        bool is_down()    { return false; }
+        bool is_changed() { return false; }
+};
+
+/// Colour of a pixel of the window, without alpha.
+static uint32_t pixel(State &m, int x, int y)
+{
+    Rect k = { x, y, 1, 1 };
+    uint32_t px = 0;
+
+    SDL_RenderReadPixels(m.r, &k, SDL_PIXELFORMAT_ARGB8888, &px, sizeof(px));
+    return px & 0xFFFFFF;
+}
+
+/// With batching on and deferral off, copies inside a cached container must
+/// be shifted by the paint origin once, not twice.
+static void test_cached_batch(State &m, Graphics &g)
+{
+    ui::TopLevel w(m, g, "top", 0, (Rect) { 0, 0, m.main_w, m.main_h });
+    w.geo.add(CENTER, 0, 0);
+    ui::Frame &f = w.add<ui::Frame>("frame", 0, (Rect) { 0, 0, 200, 100 });
+    Swatch &s = f.add<Swatch>("swatch");
+
+    f.set_cached(true);
+    g.batch(true);
+    g.defer(false);
+
+    w.refresh();
+    w.update();
+
+    CHECK(f.dims.x > 0 && f.dims.y > 0);
+
+    for (int frame = 0; frame < 2; frame++) {
+        g.clear();
+        w.draw();
+        g.flush();
+
+        int x = s.dims.x + s.dims.w / 2;
+        int y = s.dims.y + s.dims.h / 2;
+
+        CHECK(pixel(m, x, y) == RED);
+        CHECK(pixel(m, x - f.dims.x, y - f.dims.y) != RED);
+
+        g.present();
+    }
+
+    g.batch(false);
+}
+
+int main(int argc, char **argv)
+{
+    const char *font_path = argc > 1 ? argv[1] : "assets/font.otb";
+
+    try {
+        State m(320, 240, 0, "GraphicsTest", font_path, STATE_HEADLESS);
+        Graphics g(m);
+
+        test_cached_batch(m, g);
+    } catch (int err_code) {
+        fprintf(stderr, "[TEST] Exiting with error code %d\n", err_code);
+        return 1;
+    }
+
+    return test_result("graphics");
+}
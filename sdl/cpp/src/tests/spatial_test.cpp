@@ -0,0 +1,128 @@
+/*
+ * Tests for media::SpatialHash, against brute force.
+ *
+ *     spatialtest
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "media/media.hpp"
+#include "test.hpp"
+
+using namespace media;
+
+/// Deterministic, so that a failure can be reproduced.
+static inline int next_int(uint32_t &seed, int lo, int hi)
+{
+    seed = seed * 1103515245 + 12345;
+    return lo + (int) ((seed >> 8) % (uint32_t) (hi - lo + 1));
+}
+
+/// Mostly small rects around the origin, negative coordinates included, and
+/// some spanning many cells.
+static std::vector<Rect> random_rects(uint32_t seed, int n)
+{
+    std::vector<Rect> k;
+
+    for (int i = 0; i < n; i++) {
+        bool big = next_int(seed, 0, 9) == 0;
+        Rect r;
+
+        r.x = next_int(seed, -1000, 1000);
+        r.y = next_int(seed, -1000, 1000);
+        r.w = big ? next_int(seed, 100, 600) : next_int(seed, 1, 40);
+        r.h = big ? next_int(seed, 100, 600) : next_int(seed, 1, 40);
+        k.push_back(r);
+    }
+
+    return k;
+}
+
+static std::vector<SpatialHash::Pair> naive_pairs(const std::vector<Rect> &k)
+{
+    std::vector<SpatialHash::Pair> out;
+
+    for (size_t i = 0; i < k.size(); i++) {
+        for (size_t j = i + 1; j < k.size(); j++) {
+            if (util::rects_overlap(k[i], k[j]))
+                out.push_back(SpatialHash::Pair(i, j));
+        }
+    }
+
+    return out;
+}
+
+static std::vector<int> naive_query(const std::vector<Rect> &k, const Rect &q)
+{
+    std::vector<int> out;
+
+    for (size_t i = 0; i < k.size(); i++) {
+        if (util::rects_overlap(k[i], q))
+            out.push_back(i);
+    }
+
+    return out;
+}
+
+/**
+ * A small table makes distinct cells share buckets, and rects spanning
+ * several cells are seen from each of them, so a pair reported more than
+ * once or missed shows up as a difference from brute force.
+ */
+static void test_pairs(int cell, int table_bits)
+{
+    std::vector<Rect> rects = random_rects(cell * 31 + table_bits, 800);
+    std::vector<SpatialHash::Pair> got;
+    SpatialHash h(cell, table_bits);
+
+    h.build(rects);
+    h.pairs(got);
+    std::sort(got.begin(), got.end());
+
+    std::vector<SpatialHash::Pair> want = naive_pairs(rects);
+    CHECK(!want.empty());
+    CHECK(got == want);
+}
+
+/// Queries return each overlapping item once, also when repeated, which
+/// relies on the per-query stamps.
+static void test_query(int cell, int table_bits)
+{
+    std::vector<Rect> rects = random_rects(cell * 17 + table_bits, 800);
+    SpatialHash h(cell, table_bits);
+    uint32_t seed = 7;
+    int mismatches = 0;
+
+    h.build(rects);
+
+    for (int i = 0; i < 200; i++) {
+        Rect q;
+        q.x = next_int(seed, -1200, 1200);
+        q.y = next_int(seed, -1200, 1200);
+        q.w = next_int(seed, 1, 400);
+        q.h = next_int(seed, 1, 400);
+
+        for (int pass = 0; pass < 2; pass++) {
+            std::vector<int> got;
+            h.query(q, got);
+            std::sort(got.begin(), got.end());
+            if (got != naive_query(rects, q))
+                mismatches++;
+        }
+    }
+
+    CHECK(mismatches == 0);
+}
+
+int main(int argc, char **argv)
+{
+    test_pairs(64, 12);
+    test_pairs(32, 2);   // Nearly every cell collides
+    test_pairs(7, 8);    // Cell size not a power of two
+    test_query(64, 12);
+    test_query(32, 2);
+    test_query(7, 8);
+
+    return test_result("spatial");
+}
@@ -0,0 +1,31 @@
+/*
+ * Minimal test harness shared by the test executables.
+ *
+ * CHECK() reports a failed condition and carries on, so one run lists every
+ * failure. main() returns test_result(), which CTest reads as pass or fail.
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <cstdio>
+
+static int test_failures = 0;
+
+#define CHECK(x) do {                                                       \
+    if (!(x)) {                                                             \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+        test_failures++;                                                    \
+    }                                                                       \
+} while (0)
+
+static inline int test_result(const char *name)
+{
+    if (test_failures)
+        fprintf(stderr, "[TEST] %s: %d failed\n", name, test_failures);
+    else
+        printf("[TEST] %s: passed\n", name);
+    return test_failures ? 1 : 0;
+}
+
+#endif
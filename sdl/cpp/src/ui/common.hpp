@@ -10,6 +10,9 @@
 #define UI_DEFAULT_MIN_WIDTH 30
 #define UI_DEFAULT_MIN_HEIGHT 30
 
+/// Pending dirty regions after which a container repaints as a whole.
+#define UI_DIRTY_MAX 64
+
 #define UI_OPTION_DEF_MAX 24
 #define UI_OPTION_DEF_PARENT_MAX 32
 #define UI_OPTION_DEF(x) (1 << (x))
@@ -26,6 +29,8 @@ enum Options {
     OPT_WIDGET_FIXED     = UI_OPTION_DEF_PARENT(2),
     /// Have properties been set?
     OPT_WIDGET_PROPS_SET = UI_OPTION_DEF(0),
+    /// Containers: allocate the whole subtree from an arena of their own.
+    OPT_WIDGET_ARENA     = UI_OPTION_DEF(1),
 };
 
 enum WidgetState {
@@ -24,6 +24,21 @@ class Geometry {
 
         virtual Rect calculate_all(Rect dims) = 0;
         virtual Rect update_container_dim(Rect dims) = 0;
+
+        /**
+         * Lays out again only what depends on widgets whose measured size
+         * changed, consuming their layout requests.
+         * @return false if nothing moved. Otherwise widgets [first, last) may
+         *         have new dims, and container_dim is up to date.
+         */
+        virtual bool relayout(size_t &first, size_t &last) = 0;
+
+        /**
+         * Forgets the last layout and the entries added for the widgets, for
+         * when the container is cleared. The next update lays out from
+         * scratch.
+         */
+        virtual void reset() = 0;
 };
 
 
@@ -4,5 +4,6 @@
 #include "common.hpp"
 #include "grid.hpp"
 #include "relative.hpp"
+#include "hitindex.hpp"
 
 #endif
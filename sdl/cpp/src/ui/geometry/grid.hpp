@@ -1,12 +1,23 @@
 #ifndef MEDIA_UI_GEOMETRY_GRID_H
 #define MEDIA_UI_GEOMETRY_GRID_H
 
+#include <algorithm>
+
 #include "common.hpp"
 
 namespace media {
 
 namespace ui {
 
+/**
+ * Lays widgets out in blocks of rows and columns, each row as tall as its
+ * tallest widget.
+ *
+ * A full layout records every row's extent relative to the container's top.
+ * When widgets' measured sizes change later, relayout() only recomputes the
+ * heights of their rows and shifts the rows below, instead of laying out the
+ * whole grid again.
+ */
 class GridGeometry : public Geometry {
     public:
         struct GridEntry {
@@ -16,10 +27,23 @@ class GridGeometry : public Geometry {
             int repeat_till; /// @todo handle this
             int options;
         };
+
+        struct GridRow {
+            size_t first; /// Index of the row's first widget
+            int count;    /// Widgets in the row, less than cols for the last
+            int cols;
+            int margin;   /// Margin of the first widget, used for the row
+            int y;        /// Offset from the container's top
+            int h;
+            bool dirty;   /// A widget in the row changed its measured size
+        };
         
     private:
         inline GridEntry const *iter(int widget_index);
-        inline void set_row_height(int h);
+        inline int row_height(const GridRow &k);
+        inline void place_row(const GridRow &k, const Rect &area);
+        inline size_t row_of(size_t widget_index);
+        inline int content_height();
 
     public:
         static constexpr const GridEntry default_grid = { 0, 1, 1, 0 };
@@ -28,16 +52,18 @@ class GridGeometry : public Geometry {
             WidgetProperties &properties
         ): Geometry(widgets, properties) {}
         std::vector<GridEntry> grid_list;
+        std::vector<GridRow> row_list; /// Rows of the last layout
         int grid_index;
         bool initial_refresh = true;
         Rect c = {0, 0, 0, 0};
 
         inline void add(int rows, int cols, int repeat_till = 1);
-        inline void set_row_height(int widget_index, int row_start, int h);
 
         inline Rect calculate_all(Rect dims);
         inline Rect translate_all(Point pos);
         inline Rect update_container_dim(Rect dims);
+        inline bool relayout(size_t &first, size_t &last);
+        inline void reset();
 };
 
 inline void GridGeometry::add(int rows, int cols, int repeat_till)
@@ -46,13 +72,6 @@ inline void GridGeometry::add(int rows, int cols, int repeat_till)
     grid_list.emplace_back((GridEntry) { widgets.size(), rows, cols, repeat_till });
 }
 
-inline void GridGeometry::set_row_height(int widget_index, int row_start, int h)
-{
-    for (int i = row_start; i <= widget_index; i++) {
-        widgets[i]->dims.h = h;
-    }
-}
-
 inline GridGeometry::GridEntry const *GridGeometry::iter(int widget_index)
 {
     if (grid_list.size() == 0          ||
@@ -66,83 +85,172 @@ inline GridGeometry::GridEntry const *GridGeometry::iter(int widget_index)
     return &grid_list[grid_index++];
 }
 
+inline int GridGeometry::row_height(const GridRow &k)
+{
+    int h = 0;
+
+    for (int i = 0; i < k.count; i++)
+        h = std::max(h, widgets[k.first + i]->measured.h);
+
+    return h;
+}
+
+/// Sets the dims of the row's widgets, the first and last column keeping
+/// the full margin on their outer side.
+inline void GridGeometry::place_row(const GridRow &k, const Rect &area)
+{
+    int col_w  = area.w / k.cols;
+    int margin = k.margin;
+
+    for (int i = 0; i < k.count; i++) {
+        Widget &w = *widgets[k.first + i];
+
+        w.dims.x = area.x + i * col_w;
+        w.dims.y = area.y + k.y;
+        w.dims.h = k.h;
+
+        if (i == 0)
+            w.dims.x += margin;
+        else
+            w.dims.x += margin - margin / 2;
+
+        if (i == k.cols - 1 && i == 0)
+            w.dims.w = col_w - margin * 2;
+        else if (i == k.cols - 1)
+            w.dims.w = area.w - (w.dims.x - area.x) - margin;
+        else if (i == 0)
+            w.dims.w = col_w - margin / 2 - margin;
+        else
+            w.dims.w = col_w - margin;
+
+        w.get_layout_request();
+    }
+}
+
+inline size_t GridGeometry::row_of(size_t widget_index)
+{
+    auto k = std::upper_bound(row_list.begin(), row_list.end(), widget_index,
+        [](size_t i, const GridRow &r) {
+            return i < r.first;
+        });
+
+    return k - row_list.begin() - 1;
+}
+
+/// The last row is followed by a wider gap than the margin between rows.
+inline int GridGeometry::content_height()
+{
+    if (row_list.empty())
+        return properties.padding + UI_DEFAULT_MARGIN * 3;
+
+    const GridRow &k = row_list.back();
+    return k.y + k.h + UI_DEFAULT_MARGIN * 3;
+}
+
 inline Rect GridGeometry::calculate_all(Rect new_dim)
 {
     GridEntry const *curr_grid;
-    int min_grid_height;
-    int row_start;
+    int y = properties.padding;
+    size_t n = widgets.size();
     grid_index = 0;
-    Rect current_dim = new_dim;
-    current_dim.y += properties.padding;
+    initial_refresh = false;
+    row_list.clear();
 
-    for (int i = 0; i < widgets.size();) {
-        // PRINT_LINE
+    for (size_t i = 0; i < n;) {
         curr_grid = iter(i);
-        current_dim.w = new_dim.w / curr_grid->cols;
-        row_start = i;
-
-        for (int j = 0; j < curr_grid->rows; j++) {
-            int padding = widgets[i]->properties.padding;
-            int margin  = widgets[i]->properties.margin;
-            current_dim.x = new_dim.x;
-            min_grid_height = 0;
-
-            for (int k = 0; k < curr_grid->cols; k++) {
-                if (min_grid_height < widgets[i]->dims.h) {
-                    set_row_height(i, row_start, widgets[i]->dims.h);
-                    min_grid_height = widgets[i]->dims.h;
-                }
-
-                widgets[i]->dims.x = current_dim.x;
-                widgets[i]->dims.y = current_dim.y;
-
-                if (k == 0) {
-                    widgets[i]->dims.x += margin;
-                    // printf(":: %d\n", margin);
-                } else {
-                    widgets[i]->dims.x += margin - margin / 2;
-                    // printf(":: %d\n", margin - margin / 2);
-                }
-
-                if ((k == (curr_grid->cols - 1)) && (k == 0)) {
-                    widgets[i]->dims.w = current_dim.w - margin * 2;
-                    // printf("Only element\n");
-                } else if ((k == (curr_grid->cols - 1))) {
-                    widgets[i]->dims.w = new_dim.w - (widgets[i]->dims.x - new_dim.x) - margin;
-                    // PRINTRECT(current_dim);
-                    // printf("j = %d k = %d last newdim.w = %d, w = %d x = %d\n",
-                    //        j,  k, new_dim.w, widgets[i]->dims.w, widgets[i]->dims.x);
-                } else if ((k == 0)) {
-                    widgets[i]->dims.w = current_dim.w - margin / 2 - margin;
-                    //     printf("j = %d k = %d first newdim.w = %d, w = %d x = %d\n",
-                    //        j,  k, new_dim.w, widgets[i]->dims.w, widgets[i]->dims.x);
-                } else {
-                    widgets[i]->dims.w = current_dim.w - margin;
-                    // printf("j = %d k = %d Middle newdim.w = %d, w = %d x = %d\n",
-                    //        j,  k, new_dim.w, widgets[i]->dims.w, widgets[i]->dims.x);
-                }
-
-                widgets[i]->dims.h = min_grid_height;
-
-                current_dim.x += current_dim.w;
-
-                i++;
-                if (i >= widgets.size())
-                    goto end;
-            }
-            current_dim.y += min_grid_height + margin;
+
+        for (int j = 0; j < curr_grid->rows && i < n; j++) {
+            GridRow k;
+
+            k.first  = i;
+            k.count  = std::min((size_t) curr_grid->cols, n - i);
+            k.cols   = curr_grid->cols;
+            k.margin = widgets[i]->properties.margin;
+            k.y      = y;
+            k.h      = row_height(k);
+            k.dirty  = false;
+
+            row_list.push_back(k);
+            place_row(k, new_dim);
+
+            y += k.h + k.margin;
+            i += k.count;
         }
     }
 
-end:
-    current_dim.y += min_grid_height + UI_DEFAULT_MARGIN * 3;
-    // printf("Recommended size: <>%d %d %d %d\n", new_dim.y, current_dim.y, new_dim.w, current_dim.y - new_dim.y);
     // printf("Container size: %d %d\n", new_dim.w, new_dim.h);
-
-    container_dim = {new_dim.x, new_dim.y, new_dim.w, current_dim.y - new_dim.y};
+    container_dim = {new_dim.x, new_dim.y, new_dim.w, content_height()};
     return container_dim;
 }
 
+/**
+ * Rows are only as stale as the widgets in them. Each changed row is
+ * measured again, and the rows below it are moved down or up by however
+ * much it grew or shrank; columns never change, as they depend only on the
+ * container's width.
+ */
+inline bool GridGeometry::relayout(size_t &first, size_t &last)
+{
+    size_t n = widgets.size();
+    size_t from = row_list.size(), to = 0;
+
+    if (initial_refresh)
+        return false;
+
+    // Widgets added since the last layout have no row yet.
+    if (row_list.empty() ? n > 0 :
+        row_list.back().first + row_list.back().count != n) {
+        calculate_all(container_dim);
+        first = 0;
+        last = n;
+        return true;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (widgets[i]->get_layout_request()) {
+            size_t r = row_of(i);
+            row_list[r].dirty = true;
+            from = std::min(from, r);
+            to = r;
+        }
+    }
+
+    int shift = 0;
+    bool changed = false;
+
+    for (size_t r = from; r < row_list.size(); r++) {
+        GridRow &k = row_list[r];
+
+        if (shift == 0 && r > to)
+            break;
+
+        int h = k.dirty ? row_height(k) : k.h;
+        k.dirty = false;
+        k.y += shift;
+
+        if (shift == 0 && h == k.h)
+            continue;
+
+        if (!changed) {
+            first = k.first;
+            changed = true;
+        }
+
+        shift += h - k.h;
+        k.h = h;
+        last = k.first + k.count;
+
+        for (int i = 0; i < k.count; i++) {
+            Widget &w = *widgets[k.first + i];
+            w.dims.y = container_dim.y + k.y;
+            w.dims.h = k.h;
+        }
+    }
+
+    container_dim.h = content_height();
+    return changed;
+}
+
 inline Rect GridGeometry::translate_all(Point dims)
 {
     int diffx = dims.x - container_dim.x;
@@ -167,7 +275,8 @@ inline Rect GridGeometry::translate_all(Point dims)
  */
 inline Rect GridGeometry::update_container_dim(Rect new_dim)
 {
-    if (container_dim.w == new_dim.w && container_dim.h == new_dim.h) {
+    if (!initial_refresh &&
+        container_dim.w == new_dim.w && container_dim.h == new_dim.h) {
         //printf(">>>>>>>> translate\n");
         return translate_all({new_dim.x, new_dim.y});
     } else {
@@ -176,6 +285,14 @@ inline Rect GridGeometry::update_container_dim(Rect new_dim)
     }
 }
 
+inline void GridGeometry::reset()
+{
+    grid_list.clear();
+    row_list.clear();
+    grid_index = 0;
+    initial_refresh = true;
+}
+
 };
 
 };
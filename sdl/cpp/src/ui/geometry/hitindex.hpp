@@ -0,0 +1,94 @@
+#ifndef MEDIA_UI_GEOMETRY_HITINDEX_H
+#define MEDIA_UI_GEOMETRY_HITINDEX_H
+
+#include <algorithm>
+#include <climits>
+
+#include "common.hpp"
+
+namespace media {
+
+namespace ui {
+
+/**
+ * Finds the widget under a point.
+ *
+ * Widgets are kept sorted by their top edge, each with the lowest bottom
+ * edge of itself and everything above it. A lookup binary searches for the
+ * last widget starting at or above the point, then walks back only while a
+ * widget could still reach down to it; in a grid, that is one row.
+ *
+ * The index holds copies of the dims, so it must be rebuilt whenever the
+ * layout changes.
+ */
+class HitIndex {
+    protected:
+        struct Entry {
+            Rect dims;
+            int reach; /// Lowest bottom edge of this and all earlier entries
+            int index; /// Position in the widget list
+        };
+
+        std::vector<Entry> entries;
+
+    public:
+        inline void build(const WidgetList &widgets);
+        inline size_t size();
+
+        /// @return Index of the topmost shown widget containing (x, y), or -1.
+        inline int find(const WidgetList &widgets, int x, int y);
+};
+
+inline void HitIndex::build(const WidgetList &widgets)
+{
+    entries.clear();
+    entries.reserve(widgets.size());
+
+    for (size_t i = 0; i < widgets.size(); i++)
+        entries.push_back((Entry) { widgets[i]->dims, 0, (int) i });
+
+    // Stable, so equal tops keep drawing order.
+    std::stable_sort(entries.begin(), entries.end(),
+        [](const Entry &a, const Entry &b) {
+            return a.dims.y < b.dims.y;
+        });
+
+    int reach = INT_MIN;
+    for (auto &k: entries) {
+        reach = std::max(reach, k.dims.y + k.dims.h);
+        k.reach = reach;
+    }
+}
+
+inline size_t HitIndex::size()
+{
+    return entries.size();
+}
+
+inline int HitIndex::find(const WidgetList &widgets, int x, int y)
+{
+    auto k = std::upper_bound(entries.begin(), entries.end(), y,
+        [](int y, const Entry &e) {
+            return y < e.dims.y;
+        });
+
+    int hit = -1;
+
+    // Later widgets are painted over earlier ones, so the highest index wins.
+    while (k != entries.begin()) {
+        --k;
+        if (k->reach < y)
+            break;
+        if (k->index > hit && util::point_in_rect(x, y, k->dims) &&
+            widgets[k->index]->shown())
+            hit = k->index;
+    }
+
+    return hit;
+}
+
+};
+
+};
+
+#endif
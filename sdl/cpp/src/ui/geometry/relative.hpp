@@ -22,15 +22,18 @@ class RelativeGeometry : public Geometry {
     public:
         static constexpr const GravityEntry default_grav = {0, CENTER, 0, 0};
         RelativeGeometry(
-            std::vector<std::unique_ptr<Widget>> &widgets,
+            WidgetList &widgets,
             WidgetProperties &properties
         ): Geometry(widgets, properties) {}
         std::vector<GravityEntry> grav_list;
         int grav_index;
+        bool initial_refresh = true;
 
         inline void add(Gravity grav, int hpad, int vpad);
         inline Rect calculate_all(Rect new_dim);
         inline Rect update_container_dim(Rect new_dim);
+        inline bool relayout(size_t &first, size_t &last);
+        inline void reset();
 };
 
 inline void RelativeGeometry::add(Gravity grav, int hpad, int vpad)
@@ -55,11 +58,16 @@ inline Rect RelativeGeometry::calculate_all(Rect new_dim)
 {
     GravityEntry const *current_grav;
     grav_index = 0;
+    initial_refresh = false;
     //printf("RELGEO\n");
     //PRINTRECT(container_dim);
     container_dim = new_dim;
     for (int i = 0; i < widgets.size(); i++) {
         current_grav = iter(i);
+        if (widgets[i]->get_layout_request()) {
+            widgets[i]->dims.w = widgets[i]->measured.w;
+            widgets[i]->dims.h = widgets[i]->measured.h;
+        }
         widgets[i]->dims = util::rect_align(
             container_dim, widgets[i]->dims, current_grav->gravity,
             current_grav->hpad, current_grav->vpad);
@@ -74,6 +82,39 @@ inline Rect RelativeGeometry::update_container_dim(Rect new_dim)
     return calculate_all(new_dim);
 }
 
+/// Widgets are placed independently, and there are few of them, so any
+/// change simply realigns them all.
+inline bool RelativeGeometry::relayout(size_t &first, size_t &last)
+{
+    bool changed = false;
+
+    if (initial_refresh)
+        return false;
+
+    for (auto &i: widgets) {
+        if (i->get_layout_request()) {
+            i->dims.w = i->measured.w;
+            i->dims.h = i->measured.h;
+            changed = true;
+        }
+    }
+
+    if (!changed)
+        return false;
+
+    calculate_all(container_dim);
+    first = 0;
+    last = widgets.size();
+    return true;
+}
+
+inline void RelativeGeometry::reset()
+{
+    grav_list.clear();
+    grav_index = 0;
+    initial_refresh = true;
+}
+
 };
 
 };
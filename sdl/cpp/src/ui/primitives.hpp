@@ -1,12 +1,91 @@
 #ifndef MEDIA_UI_PRIMITIVES_H
 #define MEDIA_UI_PRIMITIVES_H
 
+#include <vector>
+
 namespace media {
 
 namespace ui {
 
 class Widget;
 
+/**
+ * Rectangles gathered per colour, so that a container can submit the boxes
+ * of all its children in a handful of calls.
+ *
+ * Fills are drawn before outlines. This preserves the look of a filled box
+ * with an outline, but assumes the boxes of different widgets don't overlap.
+ */
+class PrimitiveBatch {
+    protected:
+        struct Bucket {
+            Color color;
+            std::vector<Rect> rects;
+        };
+
+        // Buckets are kept between flushes so their storage is reused.
+        std::vector<Bucket> fills;
+        std::vector<Bucket> outlines;
+
+        inline std::vector<Rect> &bucket(std::vector<Bucket> &list, Color c);
+
+    public:
+        inline void fill(const Rect &k, Color c);
+        inline void outline(const Rect &k, Color c);
+        inline void flush(Graphics &g);
+
+        /// Drops what was collected without drawing it.
+        inline void clear();
+};
+
+inline std::vector<Rect> &PrimitiveBatch::bucket(std::vector<Bucket> &list, Color c)
+{
+    for (auto &i: list) {
+        if (i.color.r == c.r && i.color.g == c.g &&
+            i.color.b == c.b && i.color.a == c.a)
+            return i.rects;
+    }
+
+    list.push_back((Bucket) { c, std::vector<Rect>() });
+    return list.back().rects;
+}
+
+inline void PrimitiveBatch::fill(const Rect &k, Color c)
+{
+    bucket(fills, c).push_back(k);
+}
+
+inline void PrimitiveBatch::outline(const Rect &k, Color c)
+{
+    bucket(outlines, c).push_back(k);
+}
+
+inline void PrimitiveBatch::flush(Graphics &g)
+{
+    for (auto &i: fills) {
+        if (i.rects.empty())
+            continue;
+        g.set_color(i.color);
+        g.frects(i.rects);
+        i.rects.clear();
+    }
+
+    for (auto &i: outlines) {
+        if (i.rects.empty())
+            continue;
+        g.set_color(i.color);
+        g.rects(i.rects);
+        i.rects.clear();
+    }
+}
+
+inline void PrimitiveBatch::clear()
+{
+    for (auto &i: fills)
+        i.rects.clear();
+    for (auto &i: outlines)
+        i.rects.clear();
+}
 
 /// Primitives used for drawing the GUI components.
 class Primitives {
@@ -21,6 +100,7 @@ class Primitives {
         Primitives(Graphics &g): g(g) {};
         virtual inline int box(Rect k) = 0;
         virtual inline int fbox(Rect k) = 0;
+        virtual inline int pbox(Rect k) = 0; /// Pressed box
         virtual inline int line(Widget &u, int x1, int x2, int y1, int y2) = 0;
 };
 
@@ -30,27 +110,67 @@ class DefaultPrimitives : public Primitives {
         int margin     = UI_DEFAULT_MARGIN;
         int min_height = UI_DEFAULT_MIN_HEIGHT;
         int min_width  = UI_DEFAULT_MIN_WIDTH;
+        Color fg       = { 255, 255, 255, 255 };
+        Color bg       = { 128, 128, 128, 255 };
+
+        /// Boxes go here instead of straight to Graphics when set.
+        PrimitiveBatch *batch = nullptr;
 
     public:
         DefaultPrimitives(Graphics &g): Primitives(g) {}
         inline int box(Rect k);
         inline int fbox(Rect k);
+        inline int pbox(Rect k);
         inline int line(Widget &u, int x1, int x2, int y1, int y2);
+
+        inline void set_batch(PrimitiveBatch *b)
+        {
+            batch = b;
+        }
+
+        inline void set_colors(Color fg, Color bg)
+        {
+            this->fg = fg;
+            this->bg = bg;
+        }
 };
 
 inline int DefaultPrimitives::box(Rect k)
 {
+    if (batch != nullptr) {
+        batch->outline(k, fg);
+        return 0;
+    }
+
+    g.set_color(fg);
     return g.rect(k);
 }
 
 inline int DefaultPrimitives::fbox(Rect k)
 {
-    g.set_color(128, 128, 128, 255);
+    if (batch != nullptr) {
+        batch->fill(k, bg);
+        batch->outline(k, fg);
+        return 0;
+    }
+
+    g.set_color(bg);
     g.frect(k);
-    g.set_color(255, 255, 255, 255);
+    g.set_color(fg);
     return g.rect(k);
 }
 
+inline int DefaultPrimitives::pbox(Rect k)
+{
+    if (batch != nullptr) {
+        batch->fill(k, fg);
+        return 0;
+    }
+
+    g.set_color(fg);
+    return g.frect(k);
+}
+
 inline int DefaultPrimitives::line(Widget &u, int x1, int y1, int x2, int y2)
 {
     return g.line(x1, y1, x2, y2);
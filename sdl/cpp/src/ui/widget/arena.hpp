@@ -0,0 +1,100 @@
+#ifndef MEDIA_UI_WIDGET_ARENA_H
+#define MEDIA_UI_WIDGET_ARENA_H
+
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace media {
+
+namespace ui {
+
+/**
+ * Bump allocator for widget trees.
+ *
+ * Widgets are placed one after another in large blocks, so a tree is built
+ * without a heap allocation per widget and its children sit next to each
+ * other in memory. Nothing is freed individually: the widgets' destructors
+ * still run, but their memory goes back all at once with reset() or the
+ * arena itself.
+ */
+class WidgetArena {
+    public:
+        static const size_t BLOCK_SIZE = 16 * 1024;
+
+    protected:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t block_size;
+        size_t current = 0; /// Block being allocated from
+        size_t used = 0;    /// Bytes taken from the current block
+
+    public:
+        WidgetArena(size_t block_size = BLOCK_SIZE): block_size(block_size) {}
+
+        WidgetArena(const WidgetArena &) = delete;
+        WidgetArena &operator=(const WidgetArena &) = delete;
+
+        inline void *allocate(size_t size, size_t align);
+
+        /// Makes all memory available again. Blocks are kept for reuse, so
+        /// rebuilding a tree of the same size allocates nothing.
+        inline void reset();
+
+        inline size_t capacity();
+};
+
+inline void *WidgetArena::allocate(size_t size, size_t align)
+{
+    while (current < blocks.size()) {
+        Block &b = blocks[current];
+        uintptr_t base = (uintptr_t) b.data.get();
+        size_t offset = ((base + used + align - 1) & ~(uintptr_t) (align - 1)) - base;
+
+        if (offset + size <= b.size) {
+            used = offset + size;
+            return b.data.get() + offset;
+        }
+
+        current++;
+        used = 0;
+    }
+
+    // new[] memory is aligned for any fundamental type, so an oversized
+    // widget still starts at the block's beginning.
+    Block b;
+    b.size = size > block_size ? size : block_size;
+    b.data.reset(new char[b.size]);
+    blocks.push_back(std::move(b));
+
+    current = blocks.size() - 1;
+    used = size;
+    return blocks.back().data.get();
+}
+
+inline void WidgetArena::reset()
+{
+    current = 0;
+    used = 0;
+}
+
+inline size_t WidgetArena::capacity()
+{
+    size_t k = 0;
+    for (auto &b: blocks)
+        k += b.size;
+    return k;
+}
+
+};
+
+};
+
+#endif
@@ -7,26 +7,34 @@ namespace ui {
 
 using namespace util;
 
-void Button::draw()
+void Button::draw_back()
 {
     switch (state) {
     case UI_WIDGET_NORMAL:
         p.box(dims);
-        g.paint(o_label);
         break;
 
     case UI_WIDGET_ACTIVE:
         p.fbox(dims);
+        break;
+
+    case UI_WIDGET_DOWN:
+        p.pbox(dims);
+        break;
+    }
+}
+
+void Button::draw()
+{
+    switch (state) {
+    case UI_WIDGET_NORMAL:
+    case UI_WIDGET_ACTIVE:
         g.paint(o_label);
         break;
 
     case UI_WIDGET_DOWN:
-        g.set_color(255, 255, 255, 255);
-        g.frect(dims);
-        SDL_SetTextureColorMod(o_label.texture, 0, 0, 0);
         o_label.dest_rect.y += 1;
-        g.paint(o_label);
-        SDL_SetTextureColorMod(o_label.texture, 255, 255, 255);
+        g.paint(o_label, (Color) {0, 0, 0, 255});
         o_label.dest_rect.y -= 1;
         break;
     }
@@ -34,6 +42,8 @@ void Button::draw()
 
 bool Button::event()
 {
+    WidgetState prev = state;
+
     if (clicked_flag == true)
         clicked_flag = false;
     switch (m.e.type) {
@@ -69,6 +79,9 @@ bool Button::event()
         break;
     }
 
+    if (state != prev)
+        request_refresh();
+
     return true;
 }
 
@@ -22,6 +22,7 @@ class Button : public Widget {
             g.text(o_label, label);
             dims = o_label.dest_rect;
             dims.h += 2 * UI_DEFAULT_PADDING;
+            set_measured((Size) { dims.w, dims.h });
             PRINT_LINE
             PRINTRECT(dims);
         }
@@ -31,6 +32,7 @@ class Button : public Widget {
         }
 
         void draw();
+        void draw_back();
         bool event();
         bool update();
         void refresh();
@@ -40,6 +42,18 @@ class Button : public Widget {
             return clicked_flag;
         }
 
+        /**
+         * True once per click. Unlike is_down(), which holds until the
+         * button sees another event, reading this consumes the click, so it
+         * can be polled after events that went to other widgets.
+         */
+        inline bool clicked()
+        {
+            bool ret = clicked_flag;
+            clicked_flag = false;
+            return ret;
+        }
+
         inline bool is_changed()
         {
             return false;
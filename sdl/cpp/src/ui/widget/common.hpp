@@ -8,6 +8,7 @@
 #include "media/media.hpp"
 #include "ui/common.hpp"
 #include "ui/primitives.hpp"
+#include "arena.hpp"
 
 namespace media {
 
@@ -53,6 +54,9 @@ class Widget {
         /// Should the widget be drawn to the screen?
         bool show_flag = true;
 
+        /// Set when the measured size changes.
+        bool layout_flag = false;
+
         /// Sets the refresh flag
         inline void request_refresh()
         {
@@ -67,6 +71,13 @@ class Widget {
          * manager on invoking calculation.
          */
         Rect dims;
+
+        /**
+         * Size the widget asks for. Unlike dims it is never overwritten by the
+         * geometry manager, so it can shrink again, and a change to it only
+         * re-lays out the parts of the parent that depend on it.
+         */
+        Size measured = { 0, 0 };
         
         Widget(State &m, Graphics &g, std::string label, int options):
             m(m), g(g), p(g), label(label), options(options) {}
@@ -79,6 +90,21 @@ class Widget {
         /// Draws the widget to the screen.
         virtual void draw() = 0;
 
+        /**
+         * Draws the boxes under the widget. Containers call this for all
+         * their children before any draw(), so that the boxes can be batched.
+         */
+        virtual void draw_back() {}
+
+        /// Arena that the widget's children are allocated from, if any.
+        virtual void set_arena(WidgetArena *k) {}
+
+        /// Batch that the widget's primitives are collected in, if any.
+        inline void set_primitive_batch(PrimitiveBatch *b)
+        {
+            p.set_batch(b);
+        }
+
         /// Processes events for the given widget,
         /// @return false if refresh() needs to be invoked by the parent widget. True otherwise.
         virtual bool event() = 0;
@@ -89,11 +115,41 @@ class Widget {
 
         /**
          * Gets the request and resets it afterwards.
+         * @return true if the widget's appearance changed since the last call.
          */
-        inline bool get_refresh_request()
+        virtual inline bool get_refresh_request()
         {
-            bool ret = no_refresh_flag;
-            no_refresh_flag = false;
+            bool ret = !no_refresh_flag;
+            no_refresh_flag = true;
+            return ret;
+        }
+
+        /**
+         * Like get_refresh_request(), but appends the regions that need
+         * repainting, in window coordinates, instead of returning a flag.
+         */
+        virtual void get_dirty_rects(std::vector<Rect> &out)
+        {
+            if (get_refresh_request())
+                out.push_back(dims);
+        }
+
+        inline void set_measured(Size k)
+        {
+            if (k.w == measured.w && k.h == measured.h)
+                return;
+            measured = k;
+            layout_flag = true;
+        }
+
+        /**
+         * Gets the layout request and resets it afterwards.
+         * @return true if the measured size changed since the last call.
+         */
+        inline bool get_layout_request()
+        {
+            bool ret = layout_flag;
+            layout_flag = false;
             return ret;
         }
 
@@ -104,18 +160,22 @@ class Widget {
         
         inline void show()
         {
+            if (!show_flag)
+                request_refresh();
             show_flag = true;
         }
 
         inline void hide()
         {
+            if (show_flag)
+                request_refresh();
             show_flag = false;
         }
 
         virtual inline bool is_down() = 0;
         virtual inline bool is_changed() = 0;
 
-        virtual void set_label(std::string label)
+        virtual void set_label(const std::string &label)
         {
             this->label = label;
         }
@@ -126,8 +186,25 @@ class Widget {
         }
 };
 
+/// Deletes a widget, or only destroys it if it lives in a WidgetArena.
+struct WidgetDeleter {
+    bool in_arena;
+
+    WidgetDeleter(bool in_arena = false): in_arena(in_arena) {}
+
+    inline void operator()(Widget *k) const
+    {
+        if (in_arena)
+            k->~Widget();
+        else
+            delete k;
+    }
+};
+
+typedef std::unique_ptr<Widget, WidgetDeleter> WidgetPtr;
+
 /// Widget list alias
-typedef std::vector<std::unique_ptr<Widget>> WidgetList;
+typedef std::vector<WidgetPtr> WidgetList;
 
 };
 
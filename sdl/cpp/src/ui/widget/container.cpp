@@ -22,14 +22,9 @@ bool TopLevel::event()
     return Container::event();
 }
 
-void Frame::draw()
+void Frame::draw_back()
 {
-    g.set_color(40, 40, 40, 255);
-    g.frect(dims);
-    g.set_color(255, 255, 255, 255);
-    g.rect(dims);
-    for (auto &i: widgets)
-        i->draw();
+    p.fbox(dims);
 }
 
 };
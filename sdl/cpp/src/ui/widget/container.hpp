@@ -13,9 +13,48 @@ template <typename GeometryT>
 class Container : public Widget {
     protected:
         static constexpr char const *name = "container";
-        // DefaultPrimitives &p;
+
+        // Declared before the widgets, so that it outlives them.
+        std::unique_ptr<WidgetArena> own_arena;
+        WidgetArena *arena = nullptr; /// Own or inherited, null for the heap
+
         WidgetList widgets;
-        DefaultPrimitives p;
+        PrimitiveBatch batch; /// Collects the children's boxes
+
+        // Cached compositing. The subtree is painted into a texture which is
+        // reused until something in it requests a refresh. Children report
+        // dirty regions, and only those are repainted unless cache_dirty
+        // invalidates the whole cache.
+        bool cache_flag = false;
+        bool cache_dirty = true;
+        Object cache;
+        std::vector<Rect> dirty;
+        const Rect *clip = nullptr; /// Region being repainted, if any
+
+        // Event routing. Mouse events only go to the widget under the cursor,
+        // along with the one it just left and the one holding the button, so
+        // that those can reset. Keyboard and text events go to the widget
+        // last clicked. Anything else still goes to every child.
+        HitIndex hits;
+        Widget *hover = nullptr;
+        Widget *capture = nullptr;
+        Widget *focus = nullptr;
+
+        Widget *hit_test(int x, int y);
+        bool deliver(Widget *a, Widget *b, Widget *c);
+
+        /// Paints the container itself and its children.
+        virtual void draw_content();
+        bool prepare_cache();
+        void render_cache();
+        bool poll_dirty();
+        void relayout();
+
+        /// False if the widget lies outside the region being repainted.
+        inline bool in_clip(const Rect &k)
+        {
+            return clip == nullptr || util::rect_touches(*clip, k);
+        }
         
     public:
         GeometryT geo;
@@ -26,11 +65,18 @@ class Container : public Widget {
             std::string label,
             int options = 0,
             Rect dims = {0, 0, 0, 0}
-        ): Widget(m, g, label, options), geo(widgets, properties), p(g)
+        ): Widget(m, g, label, options), geo(widgets, properties)
         {
             PRINT_LINE
             printf("Initialiser called.\n");
             this->dims = dims;
+            set_measured((Size) { dims.w, dims.h });
+
+            if (options & OPT_WIDGET_ARENA) {
+                own_arena.reset(new WidgetArena());
+                arena = own_arena.get();
+            }
+
             // this->dims = geo.update_container_dim(dims);
             // refresh();
             //printf("EAEAEAEAEAE\n");
@@ -43,6 +89,28 @@ class Container : public Widget {
         virtual void refresh();
         virtual void resize(Rect dims);
 
+        /// Children use the parent's arena unless they have their own.
+        virtual void set_arena(WidgetArena *k)
+        {
+            if (!own_arena)
+                arena = k;
+        }
+
+        /**
+         * Destroys all children and forgets their layout. An own arena is
+         * reset in one go, ready for the next tree. A container using its
+         * parent's arena gets no memory back; that happens when the owner of
+         * the arena is cleared.
+         */
+        void clear();
+
+        /// Paint the subtree into a cached texture instead of every frame.
+        void set_cached(bool enable);
+
+        /// Also collects the requests of all children.
+        virtual bool get_refresh_request();
+        virtual void get_dirty_rects(std::vector<Rect> &out);
+
         virtual inline bool is_down()
         {
             return false;
@@ -56,8 +124,10 @@ class Container : public Widget {
         /**
          * Adds a widget to the container.
          * 
-         * unique_ptr packages the allocated data pointer into a class which
-         * will auto-delete the pointer when it goes out of scope.
+         * The widget is allocated from the arena if there is one, and from
+         * the heap otherwise. WidgetPtr packages the pointer into a class
+         * which will destroy the widget when it goes out of scope, freeing it
+         * only if it came from the heap.
          *
          * We then push it to the widget list vector via std::move, which gives
          * up ownership of the pointer to the vector. On destruction of the
@@ -67,13 +137,36 @@ class Container : public Widget {
         template <typename WidgetT, typename ...Args>
         WidgetT &add(std::string label, int options = 0, Args &&...args)
         {
-            WidgetT *k = new WidgetT(m, g, label, options, args...);
-            std::unique_ptr<WidgetT> p(k);
+            WidgetT *k;
+
+            if (arena)
+                k = new (arena->allocate(sizeof(WidgetT), alignof(WidgetT)))
+                    WidgetT(m, g, label, options, args...);
+            else
+                k = new WidgetT(m, g, label, options, args...);
+
+            WidgetPtr p(k, WidgetDeleter(arena != nullptr));
+            k->set_primitive_batch(&batch);
+            k->set_arena(arena);
             widgets.push_back(std::move(p));
             return *k;
         }
 };
 
+template <typename GeometryT>
+void Container<GeometryT>::clear()
+{
+    hover = capture = focus = nullptr;
+    widgets.clear();
+    geo.reset();
+    batch.clear();
+    hits.build(widgets);
+    cache_dirty = true;
+
+    if (own_arena)
+        own_arena->reset();
+}
+
 template <typename GeometryT>
 void Container<GeometryT>::resize(Rect dims)
 {
@@ -83,21 +176,243 @@ void Container<GeometryT>::resize(Rect dims)
 
 template <typename GeometryT>
 void Container<GeometryT>::draw()
+{
+    if (!cache_flag) {
+        dirty.clear();
+        draw_content();
+        return;
+    }
+
+    get_refresh_request();
+
+    if (!prepare_cache()) {
+        dirty.clear();
+        draw_content();
+        return;
+    }
+
+    if (cache_dirty) {
+        dirty.clear();
+        dirty.push_back(dims);
+    } else {
+        util::merge_rects(dirty);
+    }
+
+    if (!dirty.empty())
+        render_cache();
+
+    cache.set_rect(dims);
+    g.paint(cache);
+}
+
+/// The children's boxes go out first, together, and their contents on top.
+template <typename GeometryT>
+void Container<GeometryT>::draw_content()
 {
     for (auto &i: widgets) {
-        if (i->shown())
+        if (i->shown() && in_clip(i->dims))
+            i->draw_back();
+    }
+
+    batch.flush(g);
+
+    for (auto &i: widgets) {
+        if (i->shown() && in_clip(i->dims))
             i->draw();
     }
 }
 
+/// (Re)creates the cache texture when missing or of the wrong size.
+template <typename GeometryT>
+bool Container<GeometryT>::prepare_cache()
+{
+    Size k = { 0, 0 };
+
+    if (cache.texture != nullptr)
+        k = cache.tx_dims();
+
+    if (cache.texture != nullptr && k.w == dims.w && k.h == dims.h)
+        return true;
+
+    Texture *tx = create_texture(m.r, SDL_PIXELFORMAT_ARGB8888,
+                                 SDL_TEXTUREACCESS_TARGET, dims.w, dims.h);
+    if (tx == nullptr)
+        return false;
+
+    SDL_SetTextureBlendMode(tx, SDL_BLENDMODE_BLEND);
+    cache.set(tx);
+    cache_dirty = true;
+    return true;
+}
+
+/**
+ * Repaints the dirty regions of the cache, each clipped to itself.
+ *
+ * Children are laid out in window coordinates, so the paint origin is moved
+ * to the container's corner while painting into the cache. Only the cache's
+ * size matters; moving the container doesn't invalidate it.
+ */
+template <typename GeometryT>
+void Container<GeometryT>::render_cache()
+{
+    Texture *prev_target = g.get_paint_target();
+    Point prev_origin = g.get_origin();
+    Rect prev_clip;
+    bool prev_clipped = g.get_clip(prev_clip);
+
+    g.set_paint_target(cache);
+    g.set_origin((Point) { dims.x, dims.y });
+
+    for (const Rect &r: dirty) {
+        clip = &r;
+        g.set_clip(clip);
+        g.clear((Color) {0, 0, 0, 0}, r);
+        draw_content();
+    }
+
+    clip = nullptr;
+    g.set_paint_target(prev_target);
+    g.set_origin(prev_origin);
+    g.set_clip(prev_clipped ? &prev_clip : nullptr);
+
+    dirty.clear();
+    cache_dirty = false;
+}
+
+template <typename GeometryT>
+void Container<GeometryT>::set_cached(bool enable)
+{
+    cache_flag = enable;
+    cache_dirty = true;
+
+    if (!enable)
+        cache.set(nullptr);
+}
+
+/**
+ * Consumes the requests of the container and its children, adding the
+ * children's regions to the dirty list.
+ * @return true if the container as a whole needs repainting.
+ */
+template <typename GeometryT>
+bool Container<GeometryT>::poll_dirty()
+{
+    bool whole = Widget::get_refresh_request();
+
+    for (auto &i: widgets)
+        i->get_dirty_rects(dirty);
+
+    if (dirty.size() > UI_DIRTY_MAX) {
+        dirty.clear();
+        whole = true;
+    }
+
+    if (whole)
+        cache_dirty = true;
+
+    return whole;
+}
+
+template <typename GeometryT>
+bool Container<GeometryT>::get_refresh_request()
+{
+    size_t n = dirty.size();
+    bool ret = poll_dirty() || dirty.size() > n;
+
+    // Only a cache has any use for the regions.
+    if (!cache_flag)
+        dirty.clear();
+
+    return ret;
+}
+
+template <typename GeometryT>
+void Container<GeometryT>::get_dirty_rects(std::vector<Rect> &out)
+{
+    size_t n = dirty.size();
+
+    if (poll_dirty())
+        out.push_back(dims);
+    else
+        out.insert(out.end(), dirty.begin() + n, dirty.end());
+
+    if (!cache_flag)
+        dirty.clear();
+}
+
+/// The index is rebuilt on refresh, or here if widgets were added since.
+template <typename GeometryT>
+Widget *Container<GeometryT>::hit_test(int x, int y)
+{
+    if (hits.size() != widgets.size())
+        hits.build(widgets);
+
+    int i = hits.find(widgets, x, y);
+    return i < 0 ? nullptr : widgets[i].get();
+}
+
+/// Passes the current event to each distinct, shown widget given.
+template <typename GeometryT>
+bool Container<GeometryT>::deliver(Widget *a, Widget *b, Widget *c)
+{
+    Widget *k[] = { a, b, c };
+    bool no_refresh = true;
+
+    for (int i = 0; i < 3; i++) {
+        if (k[i] == nullptr || !k[i]->shown())
+            continue;
+        if ((i > 0 && k[i] == k[0]) || (i > 1 && k[i] == k[1]))
+            continue;
+        no_refresh = k[i]->event() && no_refresh;
+    }
+
+    return no_refresh;
+}
+
 template <typename GeometryT>
 bool Container<GeometryT>::event()
 {
     bool no_refresh = true;
-    for (auto &i: widgets) {
-        // Order important for optimisation
-        if (i->shown())
-            no_refresh = i->event() && no_refresh;
+    Widget *hit;
+
+    switch (m.e.type) {
+    case SDL_MOUSEMOTION:
+        hit = hit_test(m.e.motion.x, m.e.motion.y);
+        no_refresh = deliver(hover, hit, capture);
+        hover = hit;
+        break;
+
+    case SDL_MOUSEBUTTONDOWN:
+        hit = hit_test(m.e.button.x, m.e.button.y);
+        no_refresh = deliver(hover, hit, capture);
+        hover = capture = focus = hit;
+        break;
+
+    case SDL_MOUSEBUTTONUP:
+        hit = hit_test(m.e.button.x, m.e.button.y);
+        no_refresh = deliver(hover, hit, capture);
+        hover = hit;
+        capture = nullptr;
+        break;
+
+    case SDL_MOUSEWHEEL:
+        no_refresh = deliver(hover, nullptr, nullptr);
+        break;
+
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    case SDL_TEXTEDITING:
+    case SDL_TEXTINPUT:
+        no_refresh = deliver(focus, nullptr, nullptr);
+        break;
+
+    default:
+        for (auto &i: widgets) {
+            // Order important for optimisation
+            if (i->shown())
+                no_refresh = i->event() && no_refresh;
+        }
+        break;
     }
 
     if (!no_refresh) {
@@ -123,15 +438,46 @@ bool Container<GeometryT>::update()
         return false;
     }
 
+    relayout();
     return true;
 }
 
 template <typename GeometryT>
 void Container<GeometryT>::refresh()
 {
+    PROFILE_ZONE("Container::refresh");
+    cache_dirty = true;
     dims = geo.update_container_dim(dims);
+    set_measured((Size) { dims.w, dims.h });
     for (auto &i: widgets)
         i->refresh();
+
+    // Containers settle their own size in refresh(), so index afterwards.
+    hits.build(widgets);
+}
+
+/**
+ * Picks up children whose measured size changed, e.g. a label given longer
+ * text, and refreshes only the widgets the geometry manager moved. Children
+ * are updated first, so a nested container's new size is seen in the same
+ * pass.
+ */
+template <typename GeometryT>
+void Container<GeometryT>::relayout()
+{
+    size_t first, last;
+
+    if (!geo.relayout(first, last))
+        return;
+
+    PROFILE_ZONE("Container::relayout");
+    cache_dirty = true;
+    dims = geo.container_dim;
+    set_measured((Size) { dims.w, dims.h });
+    for (size_t i = first; i < last; i++)
+        widgets[i]->refresh();
+
+    hits.build(widgets);
 }
 
 /*
@@ -174,9 +520,12 @@ class Frame : public Container<GridGeometry> {
             std::string label,
             int options = 0,
             Rect dims = {0, 0, 0, 0}
-        ): Container(m, g, label, options, dims) {}
+        ): Container(m, g, label, options, dims)
+        {
+            p.set_colors((Color) {255, 255, 255, 255}, (Color) {40, 40, 40, 255});
+        }
 
-        void draw();
+        void draw_back();
 };
 
 };
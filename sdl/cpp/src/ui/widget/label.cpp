@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstdarg>
+
 #include "label.hpp"
 
 namespace media {
@@ -6,14 +9,21 @@ namespace ui {
 
 void Label::draw()
 {
-    /*printf("***\n");
-    PRINTRECT(o_label.src_rect);
-    PRINTRECT(o_label.dest_rect);
-    PRINTRECT(dims);
-    PRINTRECT(smaller(o_label.dest_rect, dims));
-    PRINTRECT(smaller_dest(o_label.dest_rect, dims));
-    printf("***\n");*/
-    g.paint(o_label);
+    if (text_size.w <= dims.w) {
+        t.draw(g, label.c_str(), text_pos);
+        return;
+    }
+
+    // Clipping splits the batch, so only overflowing text pays for it.
+    Rect prev, k = dims;
+    bool clipped = g.get_clip(prev);
+
+    if (clipped && !SDL_IntersectRect(&prev, &dims, &k))
+        return;
+
+    g.set_clip(&k);
+    t.draw(g, label.c_str(), text_pos);
+    g.set_clip(clipped ? &prev : nullptr);
 }
 
 bool Label::event()
@@ -26,17 +36,50 @@ bool Label::update()
     return true;
 }
 
+void Label::measure()
+{
+    text_size = t.size(label.c_str());
+    /// @todo remove the padding
+    set_measured((Size) { text_size.w,
+                          text_size.h + 2 * UI_DEFAULT_PADDING });
+}
+
 void Label::refresh()
 {
-    o_label.overflow_x(dims);
-    o_label.align(dims, properties.content_align);
+    // Text that doesn't fit shows its beginning.
+    Rect k = { 0, 0, std::min(text_size.w, dims.w), text_size.h };
+
+    k = util::rect_align(dims, k, properties.content_align, 0, 0);
+    text_pos = (Point) { k.x, k.y };
 }
 
-void Label::set_label(std::string label)
+void Label::set_label(const std::string &label)
 {
-    this->label = label;
-    g.text(o_label, label);
+    set_label(label.c_str());
+}
+
+void Label::set_label(const char *label)
+{
+    if (this->label.compare(label) == 0)
+        return;
+
+    // assign() reuses the existing capacity.
+    this->label.assign(label);
+    measure();
     refresh();
+    request_refresh();
+}
+
+void Label::set_labelf(const char *fmt, ...)
+{
+    char buf[FORMAT_BUFFER_SIZE];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    set_label(buf);
 }
 
 }
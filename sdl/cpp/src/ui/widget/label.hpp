@@ -8,19 +8,26 @@ namespace media {
 
 namespace ui {
 
+/**
+ * Single line of text, drawn from the default font's glyph cache. Nothing is
+ * rendered when the text changes, only its size is measured again.
+ */
 class Label : public Widget {
     protected:
         static constexpr char const *name = "label";
-        ClipObject o_label;
+        static const size_t FORMAT_BUFFER_SIZE = 256;
+        Text &t;
+        Size text_size = { 0, 0 }; /// Size of the text as drawn
+        Point text_pos = { 0, 0 }; /// Where the text is drawn within dims
+
+        void measure();
 
     public:
         Label(State &m, Graphics &g, std::string label, int options = 0):
-            Widget(m, g, label, options)
+            Widget(m, g, label, options), t(*m.text)
         {
-            g.text(o_label, label);
-            // printf("LABELINIT::: "); PRINTRECT(o_label.dest_rect);
-            dims = o_label.dest_rect;
-            dims.h += 2 * UI_DEFAULT_PADDING; /// @todo remove this
+            measure();
+            dims = (Rect) { 0, 0, measured.w, measured.h };
             PRINT_LINE
             PRINTRECT(dims);
         }
@@ -44,7 +51,13 @@ class Label : public Widget {
             return false;
         }
 
-        void set_label(std::string label);
+        /// Labels are only measured again when the text actually changes.
+        void set_label(const std::string &label);
+        void set_label(const char *label);
+
+        /// printf-style set_label(). Formats into a fixed stack buffer, so
+        /// it never allocates; output longer than the buffer is truncated.
+        void set_labelf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
 };
 
 };